@@ -0,0 +1,55 @@
+#include "Aot.h"
+
+#include <string.h>
+
+namespace SynchingFeeling
+{
+	Chip8CompiledCode::Chip8CompiledCode(const CompiledProgram& program, const UChar* memory)
+		: mProgram(program)
+		, mMemory(memory)
+		, mBlockValid(new UChar[(program.mBlockCount > 0) ? program.mBlockCount : 1])
+		, mVerify(true)
+	{
+	}
+
+	Chip8CompiledCode::~Chip8CompiledCode()
+	{
+		delete[] mBlockValid;
+	}
+
+	UInt32 Chip8CompiledCode::run(Chip8State& state, const UInt32 budget, UInt32& outWriteLength)
+	{
+		if (mVerify)
+		{
+			for (UInt32 block = 0; block < mProgram.mBlockCount; ++block)
+			{
+				verify(block);
+			}
+			mVerify = false;
+		}
+		return mProgram.mRun(state, mBlockValid, budget, outWriteLength);
+	}
+
+	void Chip8CompiledCode::invalidate()
+	{
+		mVerify = true;
+	}
+
+	void Chip8CompiledCode::invalidate(const UInt32 address, const UInt32 length)
+	{
+		// Writing the same bytes back leaves a block valid.
+		for (UInt32 block = 0; block < mProgram.mBlockCount; ++block)
+		{
+			if ((mProgram.mBlocks[block].mStart < address + length) && (mProgram.mBlocks[block].mEnd > address))
+			{
+				verify(block);
+			}
+		}
+	}
+
+	void Chip8CompiledCode::verify(const UInt32 block)
+	{
+		const CompiledBlock& range = mProgram.mBlocks[block];
+		mBlockValid[block] = (memcmp(&mMemory[range.mStart], &mProgram.mRom[range.mStart - kPCStart], range.mEnd - range.mStart) == 0) ? 1 : 0;
+	}
+}
\ No newline at end of file
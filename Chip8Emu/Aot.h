@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Machine.h"
+
+namespace SynchingFeeling
+{
+	// The bytes one compiled block was generated from.
+	struct CompiledBlock
+	{
+		UShort mStart;												// First byte
+		UShort mEnd;												// One past the last byte
+	};
+
+	// Runs compiled blocks from state.mPC until the budget can't cover the next block, control reaches code that wasn't compiled
+	// (or no longer matches memory) or a store writes to memory. Returns the budget left, a store sets outWriteLength.
+	typedef UInt32(*CompiledRunFunction)(Chip8State& state, const UChar* blockValid, UInt32 budget, UInt32& outWriteLength);
+
+	// A ROM compiled ahead of time by chip8aot.
+	struct CompiledProgram
+	{
+		const char* mName;
+		const UChar* mRom;											// The ROM it was compiled from, loaded at kPCStart
+		UInt32 mRomSize;
+		const CompiledBlock* mBlocks;
+		UInt32 mBlockCount;
+		CompiledRunFunction mRun;
+	};
+
+	// Every program compiled into this build (generated by chip8aot --registry), nullptr if this ROM wasn't.
+	const CompiledProgram* findCompiledProgram(const UChar* rom, const UInt32 size);
+
+	// For generated code, runs an instruction through its interpreter handler, true if PC should move on.
+	inline bool compiledCall(Chip8State& state, const DecodedOp& op)
+	{
+		return op.mHandler(state, op) == EIncrementPC::Yes;
+	}
+
+	// A compiled program attached to one machine.
+	// A block only runs while memory still holds the bytes it was compiled from, anything else is left to the interpreter.
+	class Chip8CompiledCode
+	{
+	public:
+		Chip8CompiledCode(const CompiledProgram& program, const UChar* memory);
+		~Chip8CompiledCode();
+
+		UInt32 run(Chip8State& state, const UInt32 budget, UInt32& outWriteLength);
+
+		// Re-checks every block, or just the blocks covering any of the given bytes, against memory.
+		void invalidate();
+		void invalidate(const UInt32 address, const UInt32 length);
+
+	private:
+		Chip8CompiledCode(const Chip8CompiledCode&);
+		Chip8CompiledCode& operator=(const Chip8CompiledCode&);
+
+		void verify(const UInt32 block);
+
+		const CompiledProgram& mProgram;
+		const UChar* mMemory;
+		UChar* mBlockValid;											// One per block
+		bool mVerify;												// Memory was replaced wholesale, re-check everything before running
+	};
+}
\ No newline at end of file
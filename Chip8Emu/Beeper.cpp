@@ -0,0 +1,187 @@
+#include "Beeper.h"
+
+#if defined HEADLESS || defined WIN32
+
+#include <string.h>
+
+using namespace std;
+
+namespace SynchingFeeling
+{
+	namespace
+	{
+		static const UInt64 kNSPerSecond = 1000000000;
+		static const UInt32 kRampsPerSecond = 2000;					// Half a millisecond to ramp a beep in or out
+		static const UInt64 kDropped = static_cast<UInt64>(1) << 32;		// Beeper::mDropped holds an event
+		static const UInt64 kDroppedActive = static_cast<UInt64>(1) << 33;	// Its state
+
+		// Smooths the step at t (0 to 1 through a cycle) for a square wave stepping dt a sample, cancelling most of its aliasing.
+		inline double polyBlep(double t, const double dt)
+		{
+			if (t < dt)
+			{
+				t /= dt;
+				return t + t - (t * t) - 1.0;
+			}
+			if (t > 1.0 - dt)
+			{
+				t = (t - 1.0) / dt;
+				return (t * t) + t + t + 1.0;
+			}
+			return 0.0;
+		}
+
+	} // namespace
+
+	SoundEventQueue::SoundEventQueue()
+		: mHead(0)
+		, mTail(0)
+	{
+		memset(mEvents, 0, sizeof(mEvents));
+	}
+
+	bool SoundEventQueue::push(const SoundEvent& event)
+	{
+		const UInt32 tail = mTail.load(memory_order_relaxed);
+		if (tail - mHead.load(memory_order_acquire) >= kCapacity)
+		{
+			return false;
+		}
+
+		mEvents[tail & (kCapacity - 1)] = event;
+		mTail.store(tail + 1, memory_order_release);
+		return true;
+	}
+
+	bool SoundEventQueue::peek(SoundEvent& outEvent) const
+	{
+		const UInt32 head = mHead.load(memory_order_relaxed);
+		if (head == mTail.load(memory_order_acquire))
+		{
+			return false;
+		}
+
+		outEvent = mEvents[head & (kCapacity - 1)];
+		return true;
+	}
+
+	void SoundEventQueue::pop()
+	{
+		mHead.store(mHead.load(memory_order_relaxed) + 1, memory_order_release);
+	}
+
+	UInt32 SoundEventQueue::getPushCount() const
+	{
+		return mTail.load(memory_order_relaxed);
+	}
+
+	UInt32 SoundEventQueue::getPopCount() const
+	{
+		return mHead.load(memory_order_relaxed);
+	}
+
+	Beeper::Beeper()
+		: mDropped(0)
+	{
+		configure(48000, 512);
+	}
+
+	void Beeper::configure(const UInt32 sampleRate, const UInt32 bufferSamples)
+	{
+		mSampleRate = (sampleRate != 0) ? sampleRate : 1;
+		mLatencyNS = (2 * static_cast<UInt64>(bufferSamples) * kNSPerSecond) / mSampleRate;
+		mStreamStartNS = 0;
+		mStreamSamples = 0;
+		mStreamStarted = false;
+		mGate = false;
+		mLevel = 0.0;
+		mRampStep = static_cast<double>(kRampsPerSecond) / mSampleRate;
+		mPhase = 0.0;
+		mPhaseStep = static_cast<double>(kBeeperToneHz) / mSampleRate;
+	}
+
+	void Beeper::push(const UInt64 timeNS, const bool active)
+	{
+		SoundEvent event;
+		event.mTimeNS = timeNS;
+		event.mActive = active;
+		if (!mEvents.push(event))
+		{
+			// Remembered so the gate doesn't stick on an older state, should this be the last event for a while.
+			mDropped.store(kDropped | (active ? kDroppedActive : 0) | mEvents.getPushCount(), memory_order_relaxed);
+		}
+	}
+
+	void Beeper::render(Int16* out, const UInt32 samples, const UInt64 nowNS)
+	{
+		// The stream keeps its own time, a sample at a time, and only snaps back to the host clock if the two drift more than a latency apart.
+		const UInt64 expectedStartNS = nowNS - mLatencyNS;
+		const UInt64 streamNS = mStreamStartNS + ((mStreamSamples * kNSPerSecond) / mSampleRate);
+		const UInt64 driftNS = (streamNS > expectedStartNS) ? (streamNS - expectedStartNS) : (expectedStartNS - streamNS);
+		if (!mStreamStarted || driftNS > mLatencyNS)
+		{
+			mStreamStartNS = expectedStartNS;
+			mStreamSamples = 0;
+			mStreamStarted = true;
+		}
+
+		for (UInt32 i = 0; i < samples; ++i, ++mStreamSamples)
+		{
+			const UInt64 sampleNS = mStreamStartNS + ((mStreamSamples * kNSPerSecond) / mSampleRate);
+
+			SoundEvent event;
+			bool anyEvents = false;
+			while (mEvents.peek(event))
+			{
+				anyEvents = true;
+				if (event.mTimeNS > sampleNS)
+				{
+					break;
+				}
+				mGate = event.mActive;
+				mEvents.pop();
+			}
+
+			// Only after an overflow, once everything pushed before the dropped event has played and nothing has been pushed since.
+			if (!anyEvents)
+			{
+				UInt64 dropped = mDropped.load(memory_order_relaxed);
+				if ((dropped & kDropped) && static_cast<UInt32>(dropped) == mEvents.getPopCount() && mDropped.compare_exchange_strong(dropped, 0, memory_order_relaxed))
+				{
+					mGate = (dropped & kDroppedActive) != 0;
+				}
+			}
+
+			if (mGate)
+			{
+				mLevel = (mLevel + mRampStep < 1.0) ? mLevel + mRampStep : 1.0;
+			}
+			else
+			{
+				mLevel = (mLevel - mRampStep > 0.0) ? mLevel - mRampStep : 0.0;
+			}
+
+			if (mLevel == 0.0)
+			{
+				// Every beep starts at the same point in the cycle.
+				mPhase = 0.0;
+				out[i] = 0;
+				continue;
+			}
+
+			double value = (mPhase < 0.5) ? 1.0 : -1.0;
+			value += polyBlep(mPhase, mPhaseStep);
+			value -= polyBlep((mPhase < 0.5) ? mPhase + 0.5 : mPhase - 0.5, mPhaseStep);
+			out[i] = static_cast<Int16>(value * mLevel * kBeeperAmplitude);
+
+			mPhase += mPhaseStep;
+			if (mPhase >= 1.0)
+			{
+				mPhase -= 1.0;
+			}
+		}
+	}
+
+} // namespace SynchingFeeling
+
+#endif //#if defined HEADLESS || defined WIN32
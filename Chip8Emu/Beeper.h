@@ -0,0 +1,86 @@
+#pragma once
+
+#include "EmuTypes.h"
+
+#if defined HEADLESS || defined WIN32
+#include <atomic>
+#endif
+
+namespace SynchingFeeling
+{
+	static const UInt32 kBeeperToneHz = 800;						// As the old sample toggle at 1600Hz
+	static const Int16 kBeeperAmplitude = 0x1000;
+
+#if defined HEADLESS || defined WIN32
+	// The sound timer starting or stopping, at a time on the host's nanosecond clock.
+	struct SoundEvent
+	{
+		UInt64 mTimeNS;
+		bool mActive;
+	};
+
+	// Lock free ring between one producer and one consumer thread, neither side ever waits.
+	class SoundEventQueue
+	{
+	public:
+		SoundEventQueue();
+
+		// Producer only. False if the ring is full and the event was dropped.
+		bool push(const SoundEvent& event);
+
+		// Consumer only. The oldest event, false if there isn't one.
+		bool peek(SoundEvent& outEvent) const;
+		void pop();
+
+		// Count of events pushed so far, producer only, and of events popped, consumer only. Both wrap.
+		UInt32 getPushCount() const;
+		UInt32 getPopCount() const;
+
+	private:
+		static const UInt32 kCapacity = 256;						// A power of two, so positions wrap with a mask
+
+		SoundEvent mEvents[kCapacity];
+		std::atomic<UInt32> mHead;									// Next to pop, consumer owned
+		std::atomic<UInt32> mTail;									// Next to push, producer owned
+	};
+
+	// Renders the beeper from sound timer transitions with sample accuracy.
+	// Events are placed a fixed latency after their timestamps, two buffers, so ones stamped while a buffer was being played still land on their own sample.
+	// The tone is a band limited (PolyBLEP) square wave, gated with a short ramp so beeps start and stop without clicks.
+	class Beeper
+	{
+	public:
+		Beeper();
+
+		// Before the audio thread starts. sampleRate and bufferSamples are what the device actually gave.
+		void configure(const UInt32 sampleRate, const UInt32 bufferSamples);
+
+		// Emulation thread. The sound timer started (active) or stopped at timeNS.
+		void push(const UInt64 timeNS, const bool active);
+
+		// Audio thread. Fills out with mono signed 16 bit samples, nowNS is the host clock as the callback started.
+		void render(Int16* out, const UInt32 samples, const UInt64 nowNS);
+
+	private:
+		Beeper(const Beeper&);
+		Beeper& operator=(const Beeper&);
+
+		SoundEventQueue mEvents;
+		// The newest event the full ring dropped: kDropped, kDroppedActive and the push count it was dropped at, 0 if there isn't one.
+		// It only stands while nothing has been pushed since, once everything before it has been played.
+		std::atomic<UInt64> mDropped;
+
+		// Audio thread only.
+		UInt32 mSampleRate;
+		UInt64 mLatencyNS;
+		UInt64 mStreamStartNS;										// Host time of the stream's first sample, less the latency
+		UInt64 mStreamSamples;										// Samples rendered since then
+		bool mStreamStarted;
+		bool mGate;													// Tone on or off at the current sample
+		double mLevel;												// Gate ramped towards 0 or 1
+		double mRampStep;
+		double mPhase;												// Through one cycle of the tone, 0 to 1
+		double mPhaseStep;
+	};
+#endif
+}
@@ -1,6 +1,108 @@
 #pragma once
 
+#include "EmuTypes.h"
+#include "Phosphor.h"
+#include "PixelExpand.h"
+#include "Upscale.h"
+
 namespace SynchingFeeling
 {
+	class Chip8Machine;
+	struct CompiledProgram;
+
+	// 600Hz, ish, at 60 frames a second.
+	static const UInt32 kDefaultInstructionsPerFrame = 10;
+
+	// 600Hz for the original loop.
+	static const UInt32 kDefaultInstructionsPerSecond = 600;
+
+	// Display refresh, frames are presented at most this often. 60Hz, ish.
+	static const UInt32 kPresentRateMS = 1000 / 60;
+
+	// How emulated time relates to wall time.
+	namespace ESpeedMode
+	{
+		enum Type
+		{
+			RealTime,		// Instructions and timers at their configured rates
+			Scaled,			// EmuConfig::mSpeedMultiplier times real time, timers included
+			Uncapped		// As fast as the host can go, timers tick with emulated frames rather than wall time
+		};
+	};
+
+	struct EmuConfig
+	{
+		// Instructions executed back to back per 60Hz frame, timers, audio, input and draw are only serviced between frames.
+		// 0 runs the original loop, one instruction per pass with everything serviced on every pass.
+		UInt32 mInstructionsPerFrame;
+
+		// Instruction rate of the original loop, from 500 up, paced to the nanosecond.
+		UInt32 mInstructionsPerSecond;
+
+		// Run frames as translated native code where the host supports it.
+		bool mJit;
+
+		// Sprites drawn across the edge of the screen carry on from the opposite edge, rather than being clipped.
+		bool mWrapSprites;
+
+		// Compiled ahead of time from the game being run, nullptr to interpret.
+		const CompiledProgram* mCompiledProgram;
+
+		// Colours of set and clear pixels, 0xAARRGGBB.
+		UInt32 mForegroundColour;
+		UInt32 mBackgroundColour;
+
+		// CPU upscaling before frames reach the screen, mUpscaleScale only applies to EUpscaleFilter::Nearest.
+		EUpscaleFilter::Type mUpscaleFilter;
+		UInt32 mUpscaleScale;
+
+		// Phosphor persistence, how much of a cleared pixel's intensity is kept each present out of 256, 0 is off.
+		UInt32 mPhosphorDecay;
+
+		// Speed against wall time, mSpeedMultiplier only applies to ESpeedMode::Scaled.
+		// Presents stay at most one per display refresh whatever the speed. Uncapped can skip them altogether, showing only the last frame.
+		ESpeedMode::Type mSpeedMode;
+		UInt32 mSpeedMultiplier;
+		bool mDrawWhenUncapped;
+
+		// The delay and sound timers tick once per 60th of a second's worth of instructions, a frame's worth when batched, rather than
+		// with wall time, so a run goes the same at any speed. Always on when uncapped.
+		bool mTimersFollowInstructions;
+
+		EmuConfig()
+			: mInstructionsPerFrame(kDefaultInstructionsPerFrame)
+			, mInstructionsPerSecond(kDefaultInstructionsPerSecond)
+			, mJit(false)
+			, mWrapSprites(false)
+			, mCompiledProgram(nullptr)
+			, mForegroundColour(kDefaultForegroundColour)
+			, mBackgroundColour(kDefaultBackgroundColour)
+			, mUpscaleFilter(EUpscaleFilter::Nearest)
+			, mUpscaleScale(1)
+			, mPhosphorDecay(0)
+			, mSpeedMode(ESpeedMode::RealTime)
+			, mSpeedMultiplier(1)
+			, mDrawWhenUncapped(true)
+			, mTimersFollowInstructions(false)
+		{}
+	};
+
+	struct EmuStats
+	{
+		UInt64 mInstructions;	// Instructions executed
+		UInt64 mFrames;			// 60Hz timer ticks, emulated ones when the timers follow the instruction count
+		UInt64 mDraws;			// platformDraw calls, frames presented (fading presents included)
+		UInt64 mDroppedFrames;	// Changed frames replaced by a newer one before they were presented
+		UInt64 mPresentLatencyTotalMS;	// Summed time from a frame first changing to it being presented
+		UInt32 mPresentLatencyMaxMS;	// Longest of those
+	};
+
+	// Reads a speed: realtime, uncapped, or <N>x for N times real time. False if it isn't one.
+	bool findSpeedMode(const char* name, ESpeedMode::Type& outMode, UInt32& outMultiplier);
+
 	void mainLoop(const char* gameName);
+	void mainLoop(const char* gameName, const EmuConfig& config, EmuStats* outStats);
+
+	// Runs an already loaded machine until the platform asks to quit.
+	void runLoop(Chip8Machine& machine, const EmuConfig& config, EmuStats* outStats);
 }
\ No newline at end of file
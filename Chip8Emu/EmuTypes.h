@@ -9,8 +9,11 @@ namespace SynchingFeeling
 	typedef unsigned int UInt32;
 	typedef short Int16;
 	typedef unsigned short UInt16;
+	typedef long long Int64;
+	typedef unsigned long long UInt64;
 
 	typedef int Address;
 
 	static const UChar kInvalidKey = 0xFF;
+	static const UChar kKeyCount = 16;								// Keypad keys 0-F, bit N of a key mask is key N
 }
\ No newline at end of file
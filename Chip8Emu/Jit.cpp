@@ -0,0 +1,652 @@
+#include "Jit.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#if defined CHIP8_JIT_X64
+#if defined _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+namespace SynchingFeeling
+{
+#if defined CHIP8_JIT_X64
+	namespace
+	{
+		// Generated code keeps the state pointer in rbx and the instruction budget left in r12d, both callee saved.
+		// eax, ecx and edx are scratch.
+		static const UInt32 kEax = 0;
+		static const UInt32 kEcx = 1;
+		static const UInt32 kEdx = 2;
+		static const UInt32 kRbx = 3;
+
+		static const UInt32 kMaxBlockCodeSize = 96 * kJitMaxBlockInstructions;	// Generous worst case for one block
+
+		static const UInt32 kStateV = offsetof(Chip8State, mV);
+		static const UInt32 kStateI = offsetof(Chip8State, mI);
+		static const UInt32 kStatePC = offsetof(Chip8State, mPC);
+		static const UInt32 kStateSP = offsetof(Chip8State, mSP);
+		static const UInt32 kStateStack = offsetof(Chip8State, mStack);
+		static const UInt32 kStateDelayTimer = offsetof(Chip8State, mDelayTimer);
+		static const UInt32 kStateSoundTimer = offsetof(Chip8State, mSoundTimer);
+
+		typedef UInt32(*JitEntry)(Chip8State*, UInt32, const UChar*);
+
+		// Anything not generated inline runs through its interpreter handler.
+		void callHandler(Chip8State* state, const DecodedOp* op)
+		{
+			if (op->mHandler(*state, *op) == EIncrementPC::Yes)
+			{
+				state->mPC += sizeof(UShort);
+			}
+		}
+
+		// Brings the timers up to the instruction instructionsAhead from the end of the run, before FX07, FX15 or FX18.
+		void syncTimersAhead(Chip8State* state, const UInt32 instructionsAhead)
+		{
+			syncTimers(*state, state->mRunEndCycle - instructionsAhead);
+		}
+
+		inline UInt32 blockIndex(const UShort pc)
+		{
+			return (pc - kPCStart) >> 1;
+		}
+
+		inline UInt32 stateV(const UChar reg)
+		{
+			return kStateV + reg;
+		}
+
+		// Appends x86-64 machine code.
+		struct Emitter
+		{
+			UChar* mBase;
+			UInt32 mUsed;
+
+			UChar* here() const { return mBase + mUsed; }
+
+			void u8(const UInt32 value)
+			{
+				mBase[mUsed++] = static_cast<UChar>(value);
+			}
+
+			void u16(const UInt32 value)
+			{
+				const UShort word = static_cast<UShort>(value);
+				memcpy(here(), &word, sizeof(word));
+				mUsed += sizeof(word);
+			}
+
+			void u32(const UInt32 value)
+			{
+				memcpy(here(), &value, sizeof(value));
+				mUsed += sizeof(value);
+			}
+
+			void u64(const UInt64 value)
+			{
+				memcpy(here(), &value, sizeof(value));
+				mUsed += sizeof(value);
+			}
+
+			// ModRM for [rbx + disp32] with reg (or an opcode extension) in the reg field.
+			void state(const UInt32 reg, const UInt32 disp)
+			{
+				u8(0x80 | (reg << 3) | kRbx);
+				u32(disp);
+			}
+
+			// Leaves a rel32 to be filled in by patch, returns where it is.
+			UInt32 rel32()
+			{
+				const UInt32 at = mUsed;
+				u32(0);
+				return at;
+			}
+
+			void patch(const UInt32 at, const UChar* target)
+			{
+				const Int32 rel = static_cast<Int32>(target - (mBase + at + sizeof(Int32)));
+				memcpy(mBase + at, &rel, sizeof(rel));
+			}
+
+			void patchImm32(const UInt32 at, const UInt32 value)
+			{
+				memcpy(mBase + at, &value, sizeof(value));
+			}
+
+			// mov byte [rbx + disp], imm8
+			void storeByteImm(const UInt32 disp, const UInt32 value) { u8(0xC6); state(0, disp); u8(value); }
+			// mov word [rbx + disp], imm16
+			void storeWordImm(const UInt32 disp, const UInt32 value) { u8(0x66); u8(0xC7); state(0, disp); u16(value); }
+			// movzx reg32, byte [rbx + disp]
+			void loadByte(const UInt32 reg, const UInt32 disp) { u8(0x0F); u8(0xB6); state(reg, disp); }
+			// movzx reg32, word [rbx + disp]
+			void loadWord(const UInt32 reg, const UInt32 disp) { u8(0x0F); u8(0xB7); state(reg, disp); }
+			// mov byte [rbx + disp], reg8
+			void storeByte(const UInt32 reg, const UInt32 disp) { u8(0x88); state(reg, disp); }
+			// mov word [rbx + disp], reg16
+			void storeWord(const UInt32 reg, const UInt32 disp) { u8(0x66); u8(0x89); state(reg, disp); }
+			// <op> byte [rbx + disp], reg8, for or (0x08), and (0x20) and xor (0x30)
+			void aluByte(const UInt32 op, const UInt32 reg, const UInt32 disp) { u8(op); state(reg, disp); }
+			// <op> byte [rbx + disp], imm8, for add (/0), and (/4) and cmp (/7)
+			void aluByteImm(const UInt32 ext, const UInt32 disp, const UInt32 value) { u8(0x80); state(ext, disp); u8(value); }
+			// cmp reg8, byte [rbx + disp]
+			void cmpByte(const UInt32 reg, const UInt32 disp) { u8(0x3A); state(reg, disp); }
+			// jmp rel32, returns the displacement to patch
+			UInt32 jmp() { u8(0xE9); return rel32(); }
+			// jcc rel32, returns the displacement to patch
+			UInt32 jcc(const UInt32 condition) { u8(0x0F); u8(0x80 | condition); return rel32(); }
+
+			// Calls a function taking (state, op) in the host's calling convention.
+			void call(const void* function, const DecodedOp* op)
+			{
+#if defined _WIN32
+				u8(0x48); u8(0x89); u8(0xD9);										// mov rcx, rbx
+				u8(0x48); u8(0xBA); u64(reinterpret_cast<UInt64>(op));				// mov rdx, op
+#else
+				u8(0x48); u8(0x89); u8(0xDF);										// mov rdi, rbx
+				u8(0x48); u8(0xBE); u64(reinterpret_cast<UInt64>(op));				// mov rsi, op
+#endif
+				u8(0x48); u8(0xB8); u64(reinterpret_cast<UInt64>(function));		// mov rax, function
+				u8(0xFF); u8(0xD0);													// call rax
+			}
+
+			// Calls a function taking (state, r12d + imm32) in the host's calling convention, returns the immediate to patch.
+			UInt32 callWithBudget(const void* function)
+			{
+#if defined _WIN32
+				u8(0x48); u8(0x89); u8(0xD9);										// mov rcx, rbx
+				u8(0x41); u8(0x8D); u8(0x94); u8(0x24);								// lea edx, [r12 + imm32]
+#else
+				u8(0x48); u8(0x89); u8(0xDF);										// mov rdi, rbx
+				u8(0x41); u8(0x8D); u8(0xB4); u8(0x24);								// lea esi, [r12 + imm32]
+#endif
+				const UInt32 at = rel32();
+				u8(0x48); u8(0xB8); u64(reinterpret_cast<UInt64>(function));		// mov rax, function
+				u8(0xFF); u8(0xD0);													// call rax
+				return at;
+			}
+		};
+
+		// jcc condition codes
+		static const UInt32 kConditionBelow = 0x2;
+		static const UInt32 kConditionEqual = 0x4;
+		static const UInt32 kConditionNotEqual = 0x5;
+
+		UChar* allocateCode()
+		{
+#if defined _WIN32
+			return static_cast<UChar*>(VirtualAlloc(nullptr, kJitCodeSize, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE));
+#else
+			int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined MAP_JIT
+			flags |= MAP_JIT;
+#endif
+			void* code = mmap(nullptr, kJitCodeSize, PROT_READ | PROT_WRITE | PROT_EXEC, flags, -1, 0);
+			return (code == MAP_FAILED) ? nullptr : static_cast<UChar*>(code);
+#endif
+		}
+
+		void freeCode(UChar* code)
+		{
+#if defined _WIN32
+			VirtualFree(code, 0, MEM_RELEASE);
+#else
+			munmap(code, kJitCodeSize);
+#endif
+		}
+	} // namespace
+
+	Chip8Jit::Chip8Jit()
+		: mCode(allocateCode())
+		, mCodeUsed(0)
+		, mCodeFlushStart(0)
+		, mExit(nullptr)
+		, mPendingWrite(0)
+	{
+		if (!mCode)
+		{
+			return;
+		}
+
+		Emitter e = { mCode, 0 };
+
+		// Entry, (state, budget, block code).
+		e.u8(0x53);																// push rbx
+		e.u8(0x41); e.u8(0x54);													// push r12
+		e.u8(0x48); e.u8(0x83); e.u8(0xEC); e.u8(0x28);							// sub rsp, 40, realigns and leaves shadow space
+#if defined _WIN32
+		e.u8(0x48); e.u8(0x89); e.u8(0xCB);										// mov rbx, rcx
+		e.u8(0x41); e.u8(0x89); e.u8(0xD4);										// mov r12d, edx
+		e.u8(0x41); e.u8(0xFF); e.u8(0xE0);										// jmp r8
+#else
+		e.u8(0x48); e.u8(0x89); e.u8(0xFB);										// mov rbx, rdi
+		e.u8(0x41); e.u8(0x89); e.u8(0xF4);										// mov r12d, esi
+		e.u8(0xFF); e.u8(0xE2);													// jmp rdx
+#endif
+
+		// Exit, returns the budget left.
+		mExit = e.here();
+		e.u8(0x44); e.u8(0x89); e.u8(0xE0);										// mov eax, r12d
+		e.u8(0x48); e.u8(0x83); e.u8(0xC4); e.u8(0x28);							// add rsp, 40
+		e.u8(0x41); e.u8(0x5C);													// pop r12
+		e.u8(0x5B);																// pop rbx
+		e.u8(0xC3);																// ret
+
+		mCodeFlushStart = e.mUsed;
+		invalidate();
+	}
+
+	Chip8Jit::~Chip8Jit()
+	{
+		if (mCode)
+		{
+			freeCode(mCode);
+		}
+	}
+
+	UInt32 Chip8Jit::run(Chip8State& state, const JitBlock& block, const UInt32 budget)
+	{
+		return reinterpret_cast<JitEntry>(mCode)(&state, budget, block.mCode);
+	}
+
+	const JitBlock* Chip8Jit::translate(const Chip8State& state, const UShort start)
+	{
+		if (kJitCodeSize - mCodeUsed < kMaxBlockCodeSize)
+		{
+			invalidate();
+		}
+
+		JitBlock& block = mBlocks[blockIndex(start)];
+		memset(&block, 0, sizeof(block));
+		block.mStart = start;
+
+		Emitter e = { mCode, mCodeUsed };
+		UChar* code = e.here();
+
+		// Not enough budget for the whole block, back to the caller to interpret what's left.
+		e.u8(0x41); e.u8(0x81); e.u8(0xFC);										// cmp r12d, count
+		const UInt32 budgetCheck = e.rel32();
+		e.patch(e.jcc(kConditionBelow), mExit);
+		e.u8(0x41); e.u8(0x81); e.u8(0xEC);										// sub r12d, count
+		const UInt32 budgetUse = e.rel32();
+
+		// Leaves for a known PC, through a jump that is linked to the block there once it exists.
+		auto exitTo = [&](const UShort target)
+		{
+			e.storeWordImm(kStatePC, target);
+			const UInt32 exit = block.mExitCount++;
+			block.mExitTarget[exit] = target;
+			block.mExitPatch[exit] = e.jmp();
+			block.mExitLinked[exit] = false;
+			e.patch(block.mExitPatch[exit], mExit);
+		};
+
+		// Leaves for wherever the code left PC.
+		auto exitDynamic = [&]()
+		{
+			e.patch(e.jmp(), mExit);
+		};
+
+		// Skips leave for the next instruction or the one after.
+		auto skip = [&](const UShort pc, const UInt32 skipCondition)
+		{
+			const UInt32 taken = e.jcc(skipCondition);
+			exitTo(pc + sizeof(UShort));
+			e.patch(taken, e.here());
+			exitTo(pc + (2 * sizeof(UShort)));
+		};
+
+		// Timers that follow the instruction count are brought up to date before each timer instruction.
+		// r12d is the budget left once the whole block is paid for, so the instruction's place in the run is only known once the block's length is.
+		const bool timersFollowInstructions = (state.mInstructionsPerTimerTick != 0);
+		UInt32 timerSyncPatch[kJitMaxBlockInstructions];
+		UInt32 timerSyncInstruction[kJitMaxBlockInstructions];
+		UInt32 timerSyncTotal = 0;
+		auto syncTimersAt = [&](const UInt32 instruction)
+		{
+			timerSyncPatch[timerSyncTotal] = e.callWithBudget(reinterpret_cast<const void*>(&syncTimersAhead));
+			timerSyncInstruction[timerSyncTotal] = instruction;
+			++timerSyncTotal;
+		};
+
+		UShort pc = start;
+		UInt32 count = 0;
+		bool ended = false;
+		while (!ended)
+		{
+			const UShort opCode = static_cast<UShort>((state.mMemory[pc] << 8) | state.mMemory[pc + 1]);
+			DecodedOp& op = mOps[blockIndex(pc)];
+			op = decodeOpCode(opCode);
+			++count;
+
+			switch (op.mOpId)
+			{
+			case EOpId::OpCode00EE:
+				e.u8(0x66); e.u8(0xFF); e.state(1, kStateSP);						// dec word [SP]
+				e.loadWord(kEax, kStateSP);
+				e.u8(0x0F); e.u8(0xB7); e.u8(0x84); e.u8(0x43); e.u32(kStateStack);	// movzx eax, word [rbx + rax * 2 + Stack]
+				e.u8(0x83); e.u8(0xC0); e.u8(sizeof(UShort));						// add eax, 2
+				e.storeWord(kEax, kStatePC);
+				exitDynamic();
+				ended = true;
+				break;
+			case EOpId::OpCode1NNN:
+				exitTo(op.mNNN);
+				ended = true;
+				break;
+			case EOpId::OpCode2NNN:
+				e.loadWord(kEax, kStateSP);
+				e.u8(0x66); e.u8(0xC7); e.u8(0x84); e.u8(0x43); e.u32(kStateStack); e.u16(pc);	// mov word [rbx + rax * 2 + Stack], pc
+				e.u8(0x66); e.u8(0xFF); e.state(0, kStateSP);						// inc word [SP]
+				exitTo(op.mNNN);
+				ended = true;
+				break;
+			case EOpId::OpCode3XNN:
+				e.aluByteImm(7, stateV(op.mX), op.mNN);
+				skip(pc, kConditionEqual);
+				ended = true;
+				break;
+			case EOpId::OpCode4XNN:
+				e.aluByteImm(7, stateV(op.mX), op.mNN);
+				skip(pc, kConditionNotEqual);
+				ended = true;
+				break;
+			case EOpId::OpCode5XY0:
+				e.loadByte(kEdx, stateV(op.mY));
+				e.cmpByte(kEdx, stateV(op.mX));
+				skip(pc, kConditionEqual);
+				ended = true;
+				break;
+			case EOpId::OpCode6XNN:
+				e.storeByteImm(stateV(op.mX), op.mNN);
+				break;
+			case EOpId::OpCode7XNN:
+				e.aluByteImm(0, stateV(op.mX), op.mNN);
+				break;
+			case EOpId::OpCode8XY0:
+				e.u8(0x8A); e.state(kEax, stateV(op.mY));							// mov al, VY
+				e.storeByte(kEax, stateV(op.mX));
+				break;
+			case EOpId::OpCode8XY1:
+			case EOpId::OpCode8XY2:
+			case EOpId::OpCode8XY3:
+			{
+				static const UChar kAluOps[] = { 0x08, 0x20, 0x30 };				// or, and, xor
+				e.u8(0x8A); e.state(kEax, stateV(op.mY));							// mov al, VY
+				e.aluByte(kAluOps[op.mOpId - EOpId::OpCode8XY1], kEax, stateV(op.mX));
+				break;
+			}
+			case EOpId::OpCode8XY4:
+			case EOpId::OpCode8XY5:
+			case EOpId::OpCode8XY7:
+			{
+				// Same flag rule as the interpreter, VF is set from the 16 bit result and written before VX.
+				const bool add = (op.mOpId == EOpId::OpCode8XY4);
+				const bool reversed = (op.mOpId == EOpId::OpCode8XY7);
+				e.loadByte(kEax, stateV(reversed ? op.mY : op.mX));
+				e.loadByte(kEcx, stateV(reversed ? op.mX : op.mY));
+				e.u8(add ? 0x01 : 0x29); e.u8(0xC8);								// add/sub eax, ecx
+				if (!add)
+				{
+					e.u8(0x0F); e.u8(0xB7); e.u8(0xC0);								// movzx eax, ax
+				}
+				e.u8(0x3D); e.u32(0xFF);											// cmp eax, 0xFF
+				e.u8(0x0F); e.u8(add ? 0x93 : 0x92); e.u8(0xC2);					// setae/setb dl
+				e.storeByte(kEdx, stateV(0xF));
+				e.storeByte(kEax, stateV(op.mX));
+				break;
+			}
+			case EOpId::OpCode8XY6:
+			case EOpId::OpCode8XYE:
+			{
+				// VY is re-read after VX is written, as the interpreter does.
+				const bool right = (op.mOpId == EOpId::OpCode8XY6);
+				e.loadByte(kEax, stateV(op.mY));
+				if (right)
+				{
+					e.u8(0xD0); e.u8(0xE8);											// shr al, 1
+				}
+				else
+				{
+					e.u8(0x00); e.u8(0xC0);											// add al, al
+				}
+				e.storeByte(kEax, stateV(op.mX));
+				e.aluByteImm(4, stateV(op.mY), right ? 0x01 : 0x80);
+				break;
+			}
+			case EOpId::OpCode9XY0:
+				e.loadByte(kEdx, stateV(op.mY));
+				e.cmpByte(kEdx, stateV(op.mX));
+				skip(pc, kConditionNotEqual);
+				ended = true;
+				break;
+			case EOpId::OpCodeANNN:
+				e.storeWordImm(kStateI, op.mNNN);
+				break;
+			case EOpId::OpCodeBNNN:
+				e.loadByte(kEax, stateV(0));
+				e.u8(0x05); e.u32(op.mNNN + sizeof(UShort));						// add eax, NNN + 2
+				e.storeWord(kEax, kStatePC);
+				exitDynamic();
+				ended = true;
+				break;
+			case EOpId::OpCodeFX07:
+				if (timersFollowInstructions)
+				{
+					syncTimersAt(count);
+				}
+				e.u8(0x8A); e.state(kEax, kStateDelayTimer);						// mov al, delay
+				e.storeByte(kEax, stateV(op.mX));
+				break;
+			case EOpId::OpCodeFX15:
+			case EOpId::OpCodeFX18:
+				if (timersFollowInstructions)
+				{
+					syncTimersAt(count);
+				}
+				e.u8(0x8A); e.state(kEax, stateV(op.mX));							// mov al, VX
+				e.storeByte(kEax, (op.mOpId == EOpId::OpCodeFX15) ? kStateDelayTimer : kStateSoundTimer);
+				break;
+			case EOpId::OpCodeFX1E:
+				e.loadByte(kEax, stateV(op.mX));
+				e.u8(0x66); e.u8(0x01); e.state(kEax, kStateI);						// add word [I], ax
+				break;
+			case EOpId::OpCode00E0:
+			case EOpId::OpCodeCXNN:
+			case EOpId::OpCodeDXYN:
+			case EOpId::OpCodeFX29:
+			case EOpId::OpCodeFX65:
+				// Always fall through to the next instruction.
+				e.storeWordImm(kStatePC, pc);
+				e.call(reinterpret_cast<const void*>(&callHandler), &op);
+				break;
+			case EOpId::OpCodeFX33:
+			case EOpId::OpCodeFX55:
+				// Writes to memory, the caller drops whatever was decoded from it before going any further.
+				e.storeWordImm(kStatePC, pc);
+				e.call(reinterpret_cast<const void*>(&callHandler), &op);
+				e.u8(0x48); e.u8(0xB8); e.u64(reinterpret_cast<UInt64>(&mPendingWrite));	// mov rax, &mPendingWrite
+				e.u8(0xC6); e.u8(0x00); e.u8(op.mWriteLength);						// mov byte [rax], length
+				exitDynamic();
+				ended = true;
+				break;
+			default:
+				// Key skips, key waits and anything unrecognised, the handler decides where PC goes.
+				e.storeWordImm(kStatePC, pc);
+				e.call(reinterpret_cast<const void*>(&callHandler), &op);
+				exitDynamic();
+				ended = true;
+				break;
+			}
+
+			pc += sizeof(UShort);
+			if (!ended && ((count == kJitMaxBlockInstructions) || (pc >= kMemorySize)))
+			{
+				exitTo(pc);
+				ended = true;
+			}
+		}
+
+		e.patchImm32(budgetCheck, count);
+		e.patchImm32(budgetUse, count);
+		for (UInt32 sync = 0; sync < timerSyncTotal; ++sync)
+		{
+			// The instruction itself and everything after it in the block, on top of the budget left.
+			e.patchImm32(timerSyncPatch[sync], count - timerSyncInstruction[sync] + 1);
+		}
+
+		block.mCode = code;
+		block.mEnd = pc;
+		block.mInstructionCount = static_cast<UShort>(count);
+		mCodeUsed = e.mUsed;
+		memset(&mCodeBytes[block.mStart], 1, block.mEnd - block.mStart);
+
+		// Chain in both directions.
+		linkTo(block);
+		for (UInt32 exit = 0; exit < block.mExitCount; ++exit)
+		{
+			const UShort target = block.mExitTarget[exit];
+			if ((target >= kPCStart) && (target < kMemorySize) && ((target & 0x1) == 0) && mBlocks[blockIndex(target)].mCode)
+			{
+				link(block, exit, mBlocks[blockIndex(target)].mCode);
+			}
+		}
+		return &block;
+	}
+
+	void Chip8Jit::link(JitBlock& block, const UInt32 exit, UChar* target)
+	{
+		Emitter e = { mCode, 0 };
+		e.patch(block.mExitPatch[exit], target);
+		block.mExitLinked[exit] = (target != mExit);
+	}
+
+	void Chip8Jit::linkTo(JitBlock& target)
+	{
+		for (JitBlock& block : mBlocks)
+		{
+			for (UInt32 exit = 0; block.mCode && (exit < block.mExitCount); ++exit)
+			{
+				if (!block.mExitLinked[exit] && (block.mExitTarget[exit] == target.mStart))
+				{
+					link(block, exit, target.mCode);
+				}
+			}
+		}
+	}
+
+	void Chip8Jit::unlinkFrom(const JitBlock& target)
+	{
+		for (JitBlock& block : mBlocks)
+		{
+			for (UInt32 exit = 0; block.mCode && (exit < block.mExitCount); ++exit)
+			{
+				if (block.mExitLinked[exit] && (block.mExitTarget[exit] == target.mStart))
+				{
+					link(block, exit, mExit);
+				}
+			}
+		}
+	}
+
+	void Chip8Jit::markCode()
+	{
+		memset(mCodeBytes, 0, sizeof(mCodeBytes));
+		for (const JitBlock& block : mBlocks)
+		{
+			if (block.mCode)
+			{
+				memset(&mCodeBytes[block.mStart], 1, block.mEnd - block.mStart);
+			}
+		}
+	}
+
+	void Chip8Jit::invalidate()
+	{
+		memset(mBlocks, 0, sizeof(mBlocks));
+		memset(mCodeBytes, 0, sizeof(mCodeBytes));
+		mCodeUsed = mCodeFlushStart;
+		mPendingWrite = 0;
+	}
+
+	void Chip8Jit::invalidate(const UInt32 address, const UInt32 length)
+	{
+		const UInt32 first = address;
+		const UInt32 last = (address + length < kMemorySize) ? address + length : kMemorySize;
+
+		// Nearly every write is to data, only go looking for blocks if a translated byte was hit.
+		bool hit = false;
+		for (UInt32 i = first; i < last; ++i)
+		{
+			hit = hit || (mCodeBytes[i] != 0);
+		}
+		if (!hit)
+		{
+			return;
+		}
+
+		// The code itself is left where it is until the next flush.
+		for (JitBlock& block : mBlocks)
+		{
+			if (block.mCode && (block.mStart < last) && (block.mEnd > first))
+			{
+				unlinkFrom(block);
+				block.mCode = nullptr;
+			}
+		}
+		markCode();
+	}
+#else
+	Chip8Jit::Chip8Jit()
+		: mCode(nullptr)
+		, mCodeUsed(0)
+		, mCodeFlushStart(0)
+		, mExit(nullptr)
+		, mPendingWrite(0)
+	{
+	}
+
+	Chip8Jit::~Chip8Jit()
+	{
+	}
+
+	UInt32 Chip8Jit::run(Chip8State&, const JitBlock&, const UInt32 budget)
+	{
+		return budget;
+	}
+
+	const JitBlock* Chip8Jit::translate(const Chip8State&, const UShort)
+	{
+		return nullptr;
+	}
+
+	void Chip8Jit::link(JitBlock&, const UInt32, UChar*)
+	{
+	}
+
+	void Chip8Jit::linkTo(JitBlock&)
+	{
+	}
+
+	void Chip8Jit::unlinkFrom(const JitBlock&)
+	{
+	}
+
+	void Chip8Jit::markCode()
+	{
+	}
+
+	void Chip8Jit::invalidate()
+	{
+	}
+
+	void Chip8Jit::invalidate(const UInt32, const UInt32)
+	{
+	}
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Machine.h"
+
+// Native code is only generated for x86-64 hosts built with CHIP8_JIT, everything else keeps interpreting.
+#if defined CHIP8_JIT && (defined __x86_64__ || defined _M_X64)
+#define CHIP8_JIT_X64
+#endif
+
+namespace SynchingFeeling
+{
+	static const UInt32 kJitMaxBlockInstructions = 32;				// Longest run of instructions translated as one block
+	static const UInt32 kJitCodeSize = 1024 * 1024;					// Executable memory per machine, flushed when full
+	static const UInt32 kJitMaxBlockExits = 2;						// Skips leave a block two ways
+
+	// A translated basic block, keyed by the PC it starts at.
+	struct JitBlock
+	{
+		UChar* mCode;												// nullptr until translated
+		UShort mStart;												// First byte covered
+		UShort mEnd;												// One past the last byte covered
+		UShort mInstructionCount;									// Every instruction in a block executes exactly once
+		UChar mExitCount;											// Exits with a known target, these can be linked
+		UShort mExitTarget[kJitMaxBlockExits];						// PC each exit leaves for
+		UInt32 mExitPatch[kJitMaxBlockExits];						// Offset of each exit's jump displacement
+		bool mExitLinked[kJitMaxBlockExits];						// Jumping straight to the target block's code
+	};
+
+	// Translates CHIP-8 basic blocks to x86-64 and runs them.
+	// Blocks end at jumps, calls, returns, skips and anything else that can leave PC somewhere other than the next instruction.
+	// Simple instructions are generated inline, the rest call their interpreter handler, so every opcode is covered.
+	// Blocks with a known successor jump straight into it once it has been translated, checking the instruction budget on entry.
+	class Chip8Jit
+	{
+	public:
+		Chip8Jit();
+		~Chip8Jit();
+
+		// False if the host can't run generated code, nothing else may be called.
+		bool isValid() const { return mCode != nullptr; }
+
+		// The block starting at pc, translating it first if need be.
+		// nullptr for any PC that can't start a block (odd, or outside program memory), interpret those.
+		const JitBlock* getBlock(const Chip8State& state, const UShort pc);
+
+		// Runs from a block until the budget can't cover the next block or control leaves for somewhere unknown.
+		// Returns how much of the budget is left, state.mPC is where to carry on from.
+		UInt32 run(Chip8State& state, const JitBlock& block, const UInt32 budget);
+
+		// Bytes written from I by the store that ended the last run, 0 if it didn't end on one.
+		UChar takePendingWrite();
+
+		// Drops every block, or just the blocks covering any of the given bytes.
+		void invalidate();
+		void invalidate(const UInt32 address, const UInt32 length);
+
+	private:
+		Chip8Jit(const Chip8Jit&);
+		Chip8Jit& operator=(const Chip8Jit&);
+
+		const JitBlock* translate(const Chip8State& state, const UShort pc);
+		void link(JitBlock& block, const UInt32 exit, UChar* target);
+		void linkTo(JitBlock& target);
+		void unlinkFrom(const JitBlock& target);
+		void markCode();
+
+		UChar* mCode;												// Executable memory
+		UInt32 mCodeUsed;											// Bytes generated so far
+		UInt32 mCodeFlushStart;										// Where blocks start, after the entry and exit stubs
+		UChar* mExit;												// Returns to the caller with the budget left
+		JitBlock mBlocks[kDecodeCacheSize];							// One per aligned PC in 0x200-0xFFF
+		DecodedOp mOps[kDecodeCacheSize];							// What handler calls are given, one per aligned PC
+		UChar mCodeBytes[kMemorySize];								// Non zero for any byte a block was translated from
+		UChar mPendingWrite;										// Written by generated code
+	};
+
+	inline const JitBlock* Chip8Jit::getBlock(const Chip8State& state, const UShort pc)
+	{
+		if ((pc < kPCStart) || (pc >= kMemorySize) || ((pc & 0x1) != 0))
+		{
+			return nullptr;
+		}
+
+		const JitBlock& block = mBlocks[(pc - kPCStart) >> 1];
+		if (block.mCode)
+		{
+			return &block;
+		}
+		return translate(state, pc);
+	}
+
+	inline UChar Chip8Jit::takePendingWrite()
+	{
+		const UChar pendingWrite = mPendingWrite;
+		mPendingWrite = 0;
+		return pendingWrite;
+	}
+}
\ No newline at end of file
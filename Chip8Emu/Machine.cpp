@@ -0,0 +1,1386 @@
+#include "Machine.h"
+#include "Aot.h"
+#include "Jit.h"
+
+#include <string.h>
+
+#if defined HEADLESS
+#include "PlatformHeadless.h"
+#elif defined WIN32
+#include "PlatformWin.h"
+#elif defined ARDUINO
+#include "PlatformArduino.h"
+#endif
+
+using namespace std;
+
+namespace SynchingFeeling
+{
+	namespace
+	{
+		// Enums
+		// Should we modify underflow/overflow registers?
+		namespace ESetFlowRegister
+		{
+			enum Type
+			{
+				Yes,
+				No
+			};
+		};
+
+		// What should we set the underflow/overflow register to on detection?
+		namespace EValueSetOnFlowDetect
+		{
+			enum Type
+			{
+				True,
+				False
+			};
+		};
+
+		// Memory map
+		namespace EMemoryMapIndex
+		{
+			enum Type
+			{
+				Interpreter,
+				FontSet,
+				PRG,
+				Max
+			};
+		};
+
+		// local types
+		typedef EOpId::Type(*DecodeFunction)(const UShort);
+
+		// general consts
+		static const UShort kDefaultSpecialReg = 0x00;				// Initial special register value
+		static const UInt32 kSpriteShift = 64 - kGFXSpriteWidth;	// Moves a sprite byte to the leftmost pixels of a row
+		static const UInt32 kSpriteMaxX = kGFXWidth - kGFXSpriteWidth;	// Rightmost column a whole sprite row fits at
+		static const UChar kFontCharacterHeight = 5;				// How many pixels high is a single font character?
+		static const UInt64 kRandMultiplier = 6364136223846793005ull;	// PCG32's LCG step
+		static const UInt64 kRandIncrement = 1442695040888963407ull;
+
+		// endian specifics
+		static const UShort kEndianCheck = 0x1234;
+		static const bool kLittleEndian =
+			*(reinterpret_cast<const UChar*>(&kEndianCheck)) != 0x12;
+		inline UShort ShortSwap(const UShort& s)
+		{
+			return (kLittleEndian) ? (((s & 0xFF) << 8) + ((s >> 8) & 0xFF)) : s;
+		}
+
+		// masks and shifts
+		static inline UShort maskShiftF000(const UShort in){ return ((in & 0xF000) >> 12); }
+		static inline UShort maskShift0F00(const UShort in){ return ((in & 0x0F00) >> 8); }
+		static inline UShort maskShift00F0(const UShort in){ return ((in & 0x00F0) >> 4); }
+		static inline UShort maskShift000F(const UShort in){ return ((in & 0x000F)); }
+
+		// In memory font
+		static const StaticUChar gFontSet[] FOR_STATIC_MEMORY =
+		{
+			0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
+			0x20, 0x60, 0x20, 0x20, 0x70, // 1
+			0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
+			0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
+			0x90, 0x90, 0xF0, 0x10, 0x10, // 4
+			0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
+			0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
+			0xF0, 0x10, 0x20, 0x40, 0x40, // 7
+			0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
+			0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
+			0xF0, 0x90, 0xF0, 0x90, 0x90, // A
+			0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
+			0xF0, 0x80, 0x80, 0x80, 0xF0, // C
+			0xE0, 0x90, 0x90, 0x90, 0xE0, // D
+			0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
+			0xF0, 0x80, 0xF0, 0x80, 0x80  // F
+		};
+
+		struct MemoryMapRange
+		{
+			UShort mMin;
+			UShort mMax;
+			MemoryMapRange(const UShort min, const UShort max)
+				: mMin(min)
+				, mMax(max)
+			{}
+		};
+
+		// https://en.wikipedia.org/wiki/CHIP-8#Memory
+		// CHIP - 8 was most commonly implemented on 4K systems, such as the Cosmac VIP and the Telmac 1800.
+		// These machines had 4096 (0x1000) memory locations, all of which are 8 bits(a byte) which is where the term CHIP - 8 originated.
+		// However, the CHIP - 8 interpreter itself occupies the first 512 bytes of the memory space on these machines.
+		// For this reason, most programs written for the original system begin at memory location 512 (0x200)
+		// and do not access any of the memory below the location 512 (0x200).The uppermost 256 bytes(0xF00 - 0xFFF)
+		// are reserved for display refresh, and the 96 bytes below that(0xEA0 - 0xEFF) were reserved for call stack,
+		// internal use, and other variables.
+		// Arduino has 32KiB of Flash memory but only 1KiB of SRAM, unlikely we'll get anything good working but some of the games are pretty
+		// small, can always try...
+		static const MemoryMapRange kMemoryMapRange[static_cast<int>(EMemoryMapIndex::Max)] =
+		{
+			MemoryMapRange(0x000, 0x1FF),	// Interpreter
+			MemoryMapRange(0x050, 0x0A0),	// Fontset
+			MemoryMapRange(0x200, 0xFFF)	// PRG
+		};
+
+		// anonymous inline methods
+		inline void incrementPC(Chip8State& state)
+		{
+			state.mPC += sizeof(UShort);
+		}
+
+		inline void setRegisterImmediate(UShort& reg, const UShort address)
+		{
+			reg = address;
+		}
+
+		inline void modifyRegisterFlow(Chip8State& state, const UShort regProxy, const ESetFlowRegister::Type setFlowRegister, const EValueSetOnFlowDetect::Type valueSet)
+		{
+			// Overflow / underflow is variable
+			if (setFlowRegister == ESetFlowRegister::Yes)
+			{
+				UChar setValueOnDetectLookup[] = { 0x01, 0x01 };
+				if (valueSet == EValueSetOnFlowDetect::False)
+				{
+					setValueOnDetectLookup[0] = 0x00;
+				}
+				else
+				{
+					setValueOnDetectLookup[1] = 0x00;
+				}
+				state.mV[0xF] = (regProxy / 0xFF != 0) ? setValueOnDetectLookup[0] : setValueOnDetectLookup[1];
+			}
+		}
+
+		inline void addToRegister(Chip8State& state, UChar& reg, const UChar value, const ESetFlowRegister::Type setFlowRegister)
+		{
+			UShort sum = reg + value;
+			modifyRegisterFlow(state, sum, setFlowRegister, EValueSetOnFlowDetect::True);
+			reg = sum % 0x100;
+		}
+
+		inline void subtractFromRegister(Chip8State& state, UChar& reg, const UChar value, const ESetFlowRegister::Type setFlowRegister)
+		{
+			UShort minus = reg - value;
+			modifyRegisterFlow(state, minus, setFlowRegister, EValueSetOnFlowDetect::False);
+			reg = minus % 0x100;
+		}
+
+		// PCG32 (XSH RR), 32 random bits from 8 bytes of state.
+		inline UInt32 nextRand(Chip8State& state)
+		{
+			const UInt64 old = state.mRandState;
+			state.mRandState = (old * kRandMultiplier) + kRandIncrement;
+			const UInt32 xorShifted = static_cast<UInt32>(((old >> 18) ^ old) >> 27);
+			const UInt32 rotate = static_cast<UInt32>(old >> 59);
+			return (xorShifted >> rotate) | (xorShifted << ((32 - rotate) & 31));
+		}
+
+		void seedRand(Chip8State& state, const UInt64 seed)
+		{
+			state.mRandSeed = seed;
+			state.mRandState = 0;
+			nextRand(state);
+			state.mRandState += seed;
+			nextRand(state);
+		}
+
+		inline bool isKeyPressed(const Chip8State& state, const UChar key)
+		{
+			return (key < kKeyCount) && (((state.mKeys >> key) & 1) != 0);
+		}
+
+		inline void setPCImmediate(Chip8State& state, const UShort address)
+		{
+			setRegisterImmediate(state.mPC, address);
+		}
+
+		inline void setIImmediate(Chip8State& state, const UShort address)
+		{
+			setRegisterImmediate(state.mI, address);
+		}
+
+		inline void cls(Chip8State& state)
+		{
+			memset(&state.mGfx, 0, sizeof(state.mGfx));
+		}
+
+		// Row i of the sprite at I, in the leftmost pixels of a screen row. Reads wrap around memory.
+		inline UInt64 spriteRow(const Chip8State& state, const UInt32 i)
+		{
+			return static_cast<UInt64>(state.mMemory[(state.mI + i) % kMemorySize]) << kSpriteShift;
+		}
+
+		inline void pushStack(Chip8State& state)
+		{
+			state.mStack[state.mSP] = state.mPC;
+			++state.mSP;
+		}
+
+		inline void popStack(Chip8State& state)
+		{
+			setPCImmediate(state, state.mStack[--state.mSP]);
+		}
+
+		// OpCode Functions
+		// One per opcode, the decoder has already picked the right one and extracted the operands.
+
+		// 00E0
+		// Clear the screen
+		EIncrementPC::Type opCode00E0(Chip8State& state, const DecodedOp&)
+		{
+			cls(state);
+			state.mDirtyRows = kGFXAllRows;
+			return EIncrementPC::Yes;
+		}
+
+		// 00EE
+		// Return from subroutine
+		EIncrementPC::Type opCode00EE(Chip8State& state, const DecodedOp&)
+		{
+			popStack(state);
+			return EIncrementPC::Yes;
+		}
+
+		// 0NNN
+		// Execute machine language subroutine at address NNN
+		EIncrementPC::Type opCode0NNN(Chip8State&, const DecodedOp&)
+		{
+			fail("0NNN not implemented");
+			return EIncrementPC::Yes;
+		}
+
+		// 1NNN
+		// Jump to address NNN
+		EIncrementPC::Type opCode1NNN(Chip8State& state, const DecodedOp& op)
+		{
+			setPCImmediate(state, op.mNNN);
+			return EIncrementPC::No;
+		}
+
+		// 2NNN
+		// Call subroutine at NNN
+		EIncrementPC::Type opCode2NNN(Chip8State& state, const DecodedOp& op)
+		{
+			pushStack(state);
+			setPCImmediate(state, op.mNNN);
+			return EIncrementPC::No;
+		}
+
+		// 3XNN
+		// Skip the next instruction if VX == NN
+		EIncrementPC::Type opCode3XNN(Chip8State& state, const DecodedOp& op)
+		{
+			if (state.mV[op.mX] == op.mNN)
+			{
+				incrementPC(state);
+			}
+			return EIncrementPC::Yes;
+		}
+
+		// 4XNN
+		// Skip the next instruction if VX != NN
+		EIncrementPC::Type opCode4XNN(Chip8State& state, const DecodedOp& op)
+		{
+			if (state.mV[op.mX] != op.mNN)
+			{
+				incrementPC(state);
+			}
+			return EIncrementPC::Yes;
+		}
+
+		// 5XY0
+		// Skip the next instruction if VX == VY
+		EIncrementPC::Type opCode5XY0(Chip8State& state, const DecodedOp& op)
+		{
+			if (state.mV[op.mX] == state.mV[op.mY])
+			{
+				incrementPC(state);
+			}
+			return EIncrementPC::Yes;
+		}
+
+		// 6XNN
+		// Sets VX to NN
+		EIncrementPC::Type opCode6XNN(Chip8State& state, const DecodedOp& op)
+		{
+			state.mV[op.mX] = op.mNN;
+			return EIncrementPC::Yes;
+		}
+
+		// 7XNN
+		// Adds NN to VX
+		EIncrementPC::Type opCode7XNN(Chip8State& state, const DecodedOp& op)
+		{
+			addToRegister(state, state.mV[op.mX], op.mNN, ESetFlowRegister::No);
+			return EIncrementPC::Yes;
+		}
+
+		// 8XY0
+		// Sets VX to the value of VY.
+		EIncrementPC::Type opCode8XY0(Chip8State& state, const DecodedOp& op)
+		{
+			state.mV[op.mX] = state.mV[op.mY];
+			return EIncrementPC::Yes;
+		}
+
+		// 8XY1
+		// Sets VX to VX or VY.
+		EIncrementPC::Type opCode8XY1(Chip8State& state, const DecodedOp& op)
+		{
+			state.mV[op.mX] |= state.mV[op.mY];
+			return EIncrementPC::Yes;
+		}
+
+		// 8XY2
+		// Sets VX to VX and VY.
+		EIncrementPC::Type opCode8XY2(Chip8State& state, const DecodedOp& op)
+		{
+			state.mV[op.mX] &= state.mV[op.mY];
+			return EIncrementPC::Yes;
+		}
+
+		// 8XY3
+		// Sets VX to VX xor VY.
+		EIncrementPC::Type opCode8XY3(Chip8State& state, const DecodedOp& op)
+		{
+			state.mV[op.mX] ^= state.mV[op.mY];
+			return EIncrementPC::Yes;
+		}
+
+		// 8XY4
+		// Add the value of register VY to register VX
+		// Set VF to 01 if a carry occurs
+		// Set VF to 00 if a carry does not occur
+		EIncrementPC::Type opCode8XY4(Chip8State& state, const DecodedOp& op)
+		{
+			addToRegister(state, state.mV[op.mX], state.mV[op.mY], ESetFlowRegister::Yes);
+			return EIncrementPC::Yes;
+		}
+
+		// 8XY5
+		// Subtract the value of register VY from register VX
+		// Set VF to 00 if a borrow occurs
+		// Set VF to 01 if a borrow does not occur
+		EIncrementPC::Type opCode8XY5(Chip8State& state, const DecodedOp& op)
+		{
+			subtractFromRegister(state, state.mV[op.mX], state.mV[op.mY], ESetFlowRegister::Yes);
+			return EIncrementPC::Yes;
+		}
+
+		// 8XY6
+		// Store the value of register VY shifted right one bit in register VX
+		// Set register VF to the least significant bit prior to the shift
+		EIncrementPC::Type opCode8XY6(Chip8State& state, const DecodedOp& op)
+		{
+			UChar& vx = state.mV[op.mX];
+			UChar& vy = state.mV[op.mY];
+			vx = vy >> 0x01;
+			vy = vy & 0x01;
+			return EIncrementPC::Yes;
+		}
+
+		// 8XY7
+		// Set register VX to the value of VY minus VX
+		// Set VF to 00 if a borrow occurs
+		// Set VF to 01 if a borrow does not occur
+		EIncrementPC::Type opCode8XY7(Chip8State& state, const DecodedOp& op)
+		{
+			UChar& vx = state.mV[op.mX];
+			UChar yCpy = state.mV[op.mY];
+			UChar xCpy = vx;
+			subtractFromRegister(state, yCpy, xCpy, ESetFlowRegister::Yes);
+			vx = yCpy;
+			return EIncrementPC::Yes;
+		}
+
+		// 8XYE
+		// Store the value of register VY shifted left one bit in register VX
+		// Set register VF to the most significant bit prior to the shift
+		EIncrementPC::Type opCode8XYE(Chip8State& state, const DecodedOp& op)
+		{
+			UChar& vx = state.mV[op.mX];
+			UChar& vy = state.mV[op.mY];
+			vx = vy << 0x01;
+			vy = vy & 0x80;
+			return EIncrementPC::Yes;
+		}
+
+		// 9XY0
+		// Skips the next instruction if VX doesn't equal VY.
+		EIncrementPC::Type opCode9XY0(Chip8State& state, const DecodedOp& op)
+		{
+			if (state.mV[op.mX] != state.mV[op.mY])
+			{
+				incrementPC(state);
+			}
+			return EIncrementPC::Yes;
+		}
+
+		// ANNN
+		// Sets I to the address NNN.
+		EIncrementPC::Type opCodeANNN(Chip8State& state, const DecodedOp& op)
+		{
+			setIImmediate(state, op.mNNN);
+			return EIncrementPC::Yes;
+		}
+
+		// BNNN
+		// Jumps to the address NNN plus V0.
+		EIncrementPC::Type opCodeBNNN(Chip8State& state, const DecodedOp& op)
+		{
+			setPCImmediate(state, state.mV[0] + op.mNNN);
+			return EIncrementPC::Yes;
+		}
+
+		// CXNN
+		// Sets VX to a random number, masked by NN.
+		EIncrementPC::Type opCodeCXNN(Chip8State& state, const DecodedOp& op)
+		{
+			state.mV[op.mX] = static_cast<UChar>(nextRand(state) >> 24) & op.mNN;
+			return EIncrementPC::Yes;
+		}
+
+		// DXYN
+		// Draw a sprite at position VX, VY with N bytes of sprite data starting at the address stored in I
+		// Set VF to 01 if any set pixels are changed to unset, and 00 otherwise
+		EIncrementPC::Type opCodeDXYN(Chip8State& state, const DecodedOp& op)
+		{
+			// The sprite's position always wraps onto the screen, ESpriteEdge decides what happens to pixels past the edges.
+			const UInt32 x = state.mV[op.mX] % kGFXWidth;
+			const UInt32 y = state.mV[op.mY] % kGFXHeight;
+			const UInt32 height = op.mN;
+
+			// Rows the sprite covers, anything past the bottom row lands in the upper half.
+			const UInt64 rows = ((static_cast<UInt64>(1) << height) - 1) << y;
+			UInt32 dirtyRows = static_cast<UInt32>(rows);
+
+			UInt64 collision = 0;
+			if ((x <= kSpriteMaxX) && (y + height <= static_cast<UInt32>(kGFXHeight)))
+			{
+				// Entirely on screen, the common case.
+				for (UInt32 i = 0; i < height; ++i)
+				{
+					const UInt64 bits = spriteRow(state, i) >> x;
+					collision |= state.mGfx[y + i] & bits;
+					state.mGfx[y + i] ^= bits;
+				}
+			}
+			else if (state.mSpriteEdge == ESpriteEdge::Wrap)
+			{
+				// Rotating carries pixels past the right edge round to the left.
+				dirtyRows |= static_cast<UInt32>(rows >> kGFXHeight);
+				for (UInt32 i = 0; i < height; ++i)
+				{
+					const UInt64 sprite = spriteRow(state, i);
+					const UInt64 bits = (sprite >> x) | (sprite << ((kGFXWidth - x) % kGFXWidth));
+					const UInt32 row = (y + i) % kGFXHeight;
+					collision |= state.mGfx[row] & bits;
+					state.mGfx[row] ^= bits;
+				}
+			}
+			else
+			{
+				// Shifting drops pixels past the right edge.
+				const UInt32 visibleRows = (y + height <= static_cast<UInt32>(kGFXHeight)) ? height : kGFXHeight - y;
+				for (UInt32 i = 0; i < visibleRows; ++i)
+				{
+					const UInt64 bits = spriteRow(state, i) >> x;
+					collision |= state.mGfx[y + i] & bits;
+					state.mGfx[y + i] ^= bits;
+				}
+			}
+
+			// Collision
+			state.mV[0xF] = (collision != 0) ? 0x01 : 0x00;
+			state.mDirtyRows |= dirtyRows;
+			return EIncrementPC::Yes;
+		}
+
+		// EX9E
+		// Skips the next instruction if the key stored in VX is pressed.
+		EIncrementPC::Type opCodeEX9E(Chip8State& state, const DecodedOp& op)
+		{
+			if (isKeyPressed(state, state.mV[op.mX]))
+			{
+				incrementPC(state);
+			}
+			return EIncrementPC::Yes;
+		}
+
+		// EXA1
+		// Skips the next instruction if the key stored in VX isn't pressed.
+		EIncrementPC::Type opCodeEXA1(Chip8State& state, const DecodedOp& op)
+		{
+			if (!isKeyPressed(state, state.mV[op.mX]))
+			{
+				incrementPC(state);
+			}
+			return EIncrementPC::Yes;
+		}
+
+		// FX07
+		// Sets VX to the value of the delay timer
+		EIncrementPC::Type opCodeFX07(Chip8State& state, const DecodedOp& op)
+		{
+			syncTimers(state, state.mCycleCount);
+			state.mV[op.mX] = state.mDelayTimer;
+			return EIncrementPC::Yes;
+		}
+
+		// FX0A
+		// A key press is awaited, and then stored in VX.
+		// With more than one key down, the lowest is taken.
+		EIncrementPC::Type opCodeFX0A(Chip8State& state, const DecodedOp& op)
+		{
+			for (UChar key = 0; key < kKeyCount; ++key)
+			{
+				if (isKeyPressed(state, key))
+				{
+					state.mV[op.mX] = key;
+					return EIncrementPC::Yes;
+				}
+			}
+			return EIncrementPC::No;
+		}
+
+		// FX15
+		// Sets the delay timer to VX.
+		EIncrementPC::Type opCodeFX15(Chip8State& state, const DecodedOp& op)
+		{
+			syncTimers(state, state.mCycleCount);
+			state.mDelayTimer = state.mV[op.mX];
+			return EIncrementPC::Yes;
+		}
+
+		// FX18
+		// Sets the sound timer to VX.
+		EIncrementPC::Type opCodeFX18(Chip8State& state, const DecodedOp& op)
+		{
+			syncTimers(state, state.mCycleCount);
+			state.mSoundTimer = state.mV[op.mX];
+			return EIncrementPC::Yes;
+		}
+
+		// FX1E
+		// Adds VX to I.[3]
+		EIncrementPC::Type opCodeFX1E(Chip8State& state, const DecodedOp& op)
+		{
+			state.mI += state.mV[op.mX];
+			return EIncrementPC::Yes;
+		}
+
+		// FX29
+		// Sets I to the location of the sprite for the character in VX.
+		// Characters 0 - F(in hexadecimal) are represented by a 4x5 font.
+		EIncrementPC::Type opCodeFX29(Chip8State& state, const DecodedOp& op)
+		{
+			const MemoryMapRange& fontSetMemoryRange = kMemoryMapRange[static_cast<UChar>(EMemoryMapIndex::FontSet)];
+			state.mI = fontSetMemoryRange.mMin + (state.mV[op.mX] * kFontCharacterHeight);
+			return EIncrementPC::Yes;
+		}
+
+		// FX33
+		// Stores the Binary - coded decimal representation of VX, with the most significant of three digits at the address in I,
+		// the middle digit at I plus 1, and the least significant digit at I plus 2.
+		// (In other words, take the decimal representation of VX, place the hundreds digit in memory at location in I,
+		// the tens digit at location I + 1, and the ones digit at location I + 2.)
+		EIncrementPC::Type opCodeFX33(Chip8State& state, const DecodedOp& op)
+		{
+			const UChar vx = state.mV[op.mX];
+			state.mMemory[state.mI] = vx / 100;
+			state.mMemory[state.mI + 1] = (vx / 10) % 10;
+			state.mMemory[state.mI + 2] = (vx % 10) % 10;
+			return EIncrementPC::Yes;
+		}
+
+		// FX55
+		// Stores V0 to VX in memory starting at address I.
+		EIncrementPC::Type opCodeFX55(Chip8State& state, const DecodedOp& op)
+		{
+			for (UChar i = 0; i <= op.mX; ++i)
+			{
+				state.mMemory[state.mI + i] = state.mV[i];
+			}
+			return EIncrementPC::Yes;
+		}
+
+		// FX65
+		// Fills V0 to VX with values from memory starting at address I.
+		EIncrementPC::Type opCodeFX65(Chip8State& state, const DecodedOp& op)
+		{
+			for (UChar i = 0; i <= op.mX; ++i)
+			{
+				state.mV[i] = state.mMemory[state.mI + i];
+			}
+			return EIncrementPC::Yes;
+		}
+
+		// Anything the decoder doesn't recognise
+		EIncrementPC::Type opCodeInvalid(Chip8State&, const DecodedOp& op)
+		{
+			fail("Invalid opcode: ", op.mOpCode);
+			return EIncrementPC::No;
+		}
+
+		// Handlers by EOpId
+		static const OpHandler gOpHandlers[EOpId::Max] =
+		{
+			&opCode00E0,
+			&opCode00EE,
+			&opCode0NNN,
+			&opCode1NNN,
+			&opCode2NNN,
+			&opCode3XNN,
+			&opCode4XNN,
+			&opCode5XY0,
+			&opCode6XNN,
+			&opCode7XNN,
+			&opCode8XY0,
+			&opCode8XY1,
+			&opCode8XY2,
+			&opCode8XY3,
+			&opCode8XY4,
+			&opCode8XY5,
+			&opCode8XY6,
+			&opCode8XY7,
+			&opCode8XYE,
+			&opCode9XY0,
+			&opCodeANNN,
+			&opCodeBNNN,
+			&opCodeCXNN,
+			&opCodeDXYN,
+			&opCodeEX9E,
+			&opCodeEXA1,
+			&opCodeFX07,
+			&opCodeFX0A,
+			&opCodeFX15,
+			&opCodeFX18,
+			&opCodeFX1E,
+			&opCodeFX29,
+			&opCodeFX33,
+			&opCodeFX55,
+			&opCodeFX65,
+			&opCodeInvalid,
+		};
+
+		// Decode Functions
+		// Resolve the instruction within each top nibble, run once per instruction rather than once per execution.
+		EOpId::Type decode0xxx(const UShort opCode)
+		{
+			switch (opCode)
+			{
+				case 0x00E0: return EOpId::OpCode00E0;
+				case 0x00EE: return EOpId::OpCode00EE;
+				default: return EOpId::OpCode0NNN;
+			}
+		}
+
+		EOpId::Type decode1xxx(const UShort) { return EOpId::OpCode1NNN; }
+		EOpId::Type decode2xxx(const UShort) { return EOpId::OpCode2NNN; }
+		EOpId::Type decode3xxx(const UShort) { return EOpId::OpCode3XNN; }
+		EOpId::Type decode4xxx(const UShort) { return EOpId::OpCode4XNN; }
+		EOpId::Type decode5xxx(const UShort) { return EOpId::OpCode5XY0; }
+		EOpId::Type decode6xxx(const UShort) { return EOpId::OpCode6XNN; }
+		EOpId::Type decode7xxx(const UShort) { return EOpId::OpCode7XNN; }
+
+		EOpId::Type decode8xxx(const UShort opCode)
+		{
+			switch (maskShift000F(opCode))
+			{
+				case 0x0: return EOpId::OpCode8XY0;
+				case 0x1: return EOpId::OpCode8XY1;
+				case 0x2: return EOpId::OpCode8XY2;
+				case 0x3: return EOpId::OpCode8XY3;
+				case 0x4: return EOpId::OpCode8XY4;
+				case 0x5: return EOpId::OpCode8XY5;
+				case 0x6: return EOpId::OpCode8XY6;
+				case 0x7: return EOpId::OpCode8XY7;
+				case 0xE: return EOpId::OpCode8XYE;
+				default: return EOpId::OpCodeInvalid;
+			}
+		}
+
+		EOpId::Type decode9xxx(const UShort) { return EOpId::OpCode9XY0; }
+		EOpId::Type decodeAxxx(const UShort) { return EOpId::OpCodeANNN; }
+		EOpId::Type decodeBxxx(const UShort) { return EOpId::OpCodeBNNN; }
+		EOpId::Type decodeCxxx(const UShort) { return EOpId::OpCodeCXNN; }
+		EOpId::Type decodeDxxx(const UShort) { return EOpId::OpCodeDXYN; }
+
+		EOpId::Type decodeExxx(const UShort opCode)
+		{
+			switch (opCode & 0x00FF)
+			{
+				case 0x009E: return EOpId::OpCodeEX9E;
+				case 0x00A1: return EOpId::OpCodeEXA1;
+				default: return EOpId::OpCodeInvalid;
+			}
+		}
+
+		EOpId::Type decodeFxxx(const UShort opCode)
+		{
+			switch (opCode & 0x00FF)
+			{
+				case 0x0007: return EOpId::OpCodeFX07;
+				case 0x000A: return EOpId::OpCodeFX0A;
+				case 0x0015: return EOpId::OpCodeFX15;
+				case 0x0018: return EOpId::OpCodeFX18;
+				case 0x001E: return EOpId::OpCodeFX1E;
+				case 0x0029: return EOpId::OpCodeFX29;
+				case 0x0033: return EOpId::OpCodeFX33;
+				case 0x0055: return EOpId::OpCodeFX55;
+				case 0x0065: return EOpId::OpCodeFX65;
+				default: return EOpId::OpCodeInvalid;
+			}
+		}
+
+		// The VM
+		// Immutable, so it is safe to share between machines on any thread.
+		static const DecodeFunction gVM[] =
+		{
+			&decode0xxx,
+			&decode1xxx,
+			&decode2xxx,
+			&decode3xxx,
+			&decode4xxx,
+			&decode5xxx,
+			&decode6xxx,
+			&decode7xxx,
+			&decode8xxx,
+			&decode9xxx,
+			&decodeAxxx,
+			&decodeBxxx,
+			&decodeCxxx,
+			&decodeDxxx,
+			&decodeExxx,
+			&decodeFxxx,
+		};
+
+		inline UShort fetchOpCode(const Chip8State& state, const UShort pc)
+		{
+			UShort op;
+			memcpy(&op, &state.mMemory[pc & (kMemorySize - 1)], sizeof(UShort));
+			return ShortSwap(op);
+		}
+
+		inline bool isDecodeCacheable(const UShort pc)
+		{
+			return (pc >= kPCStart) && (pc < kMemorySize) && ((pc & 0x1) == 0);
+		}
+
+		inline UInt32 decodeCacheIndex(const UShort pc)
+		{
+			return (pc - kPCStart) >> 1;
+		}
+
+	} // namespace
+
+	DecodedOp decodeOpCode(const UShort opCode)
+	{
+		DecodedOp op;
+		const EOpId::Type opId = gVM[maskShiftF000(opCode)](opCode);
+		op.mHandler = gOpHandlers[opId];
+		op.mOpId = static_cast<UChar>(opId);
+		op.mOpCode = opCode;
+		op.mNNN = opCode & 0x0FFF;
+		op.mX = static_cast<UChar>(maskShift0F00(opCode));
+		op.mY = static_cast<UChar>(maskShift00F0(opCode));
+		op.mN = static_cast<UChar>(maskShift000F(opCode));
+		op.mNN = static_cast<UChar>(opCode & 0x00FF);
+		op.mWriteLength = 0;
+		if (opId == EOpId::OpCodeFX33)
+		{
+			op.mWriteLength = 3;
+		}
+		else if (opId == EOpId::OpCodeFX55)
+		{
+			op.mWriteLength = op.mX + 1;
+		}
+		return op;
+	}
+
+	Chip8Machine::Chip8Machine()
+		: mJit(nullptr)
+		, mCompiled(nullptr)
+	{
+		// reset() keeps the settings that survive it, a new machine starts with all of them off.
+		memset(&mState, 0, sizeof(mState));
+		reset();
+	}
+
+	Chip8Machine::~Chip8Machine()
+	{
+		delete mJit;
+		delete mCompiled;
+	}
+
+	bool Chip8Machine::setJitEnabled(const bool enabled)
+	{
+		if (enabled && !mJit)
+		{
+			mJit = new Chip8Jit();
+			if (!mJit->isValid())
+			{
+				delete mJit;
+				mJit = nullptr;
+			}
+		}
+		else if (!enabled && mJit)
+		{
+			delete mJit;
+			mJit = nullptr;
+		}
+		return mJit != nullptr;
+	}
+
+	void Chip8Machine::setCompiledProgram(const CompiledProgram* program)
+	{
+		delete mCompiled;
+		mCompiled = (program) ? new Chip8CompiledCode(*program, mState.mMemory) : nullptr;
+	}
+
+	void Chip8Machine::reset()
+	{
+		const UChar spriteEdge = mState.mSpriteEdge;
+		const UInt32 instructionsPerTimerTick = mState.mInstructionsPerTimerTick;
+		const UInt64 randSeed = mState.mRandSeed;
+		memset(&mState, 0, sizeof(mState));
+
+		mState.mPC = kPCStart;
+		mState.mI = kDefaultSpecialReg;
+		mState.mSP = kDefaultSpecialReg;
+		mState.mKeys = 0;
+		mState.mDirtyRows = 0;
+		mState.mCycleCount = 0;
+		mState.mSpriteEdge = spriteEdge;
+		mState.mInstructionsPerTimerTick = instructionsPerTimerTick;
+		seedRand(mState, randSeed);
+
+		// load font from memory
+		const MemoryMapRange& fontSetMemoryRange = kMemoryMapRange[static_cast<UChar>(EMemoryMapIndex::FontSet)];
+		memcpy(&mState.mMemory[fontSetMemoryRange.mMin], gFontSet, sizeof(gFontSet));
+
+		invalidateDecodeCache();
+	}
+
+	char* Chip8Machine::getProgramMemory()
+	{
+		invalidateDecodeCache();
+
+		const MemoryMapRange& prgMemoryMapRange = kMemoryMapRange[static_cast<UChar>(EMemoryMapIndex::PRG)];
+		return reinterpret_cast<char*>(&mState.mMemory[prgMemoryMapRange.mMin]);
+	}
+
+	UInt32 Chip8Machine::getProgramMemorySize() const
+	{
+		const MemoryMapRange& prgMemoryMapRange = kMemoryMapRange[static_cast<UChar>(EMemoryMapIndex::PRG)];
+		return prgMemoryMapRange.mMax - prgMemoryMapRange.mMin;
+	}
+
+	void Chip8Machine::loadProgram(const UChar* program, const UInt32 size)
+	{
+		const UInt32 programMemorySize = getProgramMemorySize();
+		memcpy(getProgramMemory(), program, (size < programMemorySize) ? size : programMemorySize);
+	}
+
+	void Chip8Machine::setState(const Chip8State& state)
+	{
+		mState = state;
+		invalidateDecodeCache();
+	}
+
+	inline const DecodedOp& Chip8Machine::fetchDecoded(const UShort pc)
+	{
+		if (isDecodeCacheable(pc))
+		{
+			const DecodedOp& op = mDecodeCache[decodeCacheIndex(pc)];
+			if (op.mHandler)
+			{
+				return op;
+			}
+		}
+		return decode(pc);
+	}
+
+	const DecodedOp& Chip8Machine::decode(const UShort pc)
+	{
+		DecodedOp& op = (isDecodeCacheable(pc)) ? mDecodeCache[decodeCacheIndex(pc)] : mUncachedOp;
+		op = decodeOpCode(fetchOpCode(mState, pc));
+		return op;
+	}
+
+	void Chip8Machine::invalidateDecodeCache()
+	{
+		memset(mDecodeCache, 0, sizeof(mDecodeCache));
+		if (mJit)
+		{
+			mJit->invalidate();
+		}
+		if (mCompiled)
+		{
+			mCompiled->invalidate();
+		}
+	}
+
+	void Chip8Machine::invalidateDecodeCache(const UInt32 address, const UInt32 length)
+	{
+		// An instruction starting one byte before the write overlaps it too.
+		UInt32 first = (address > 0) ? address - 1 : 0;
+		UInt32 last = address + length - 1;
+		if (first < kPCStart)
+		{
+			first = kPCStart;
+		}
+		if (last >= kMemorySize)
+		{
+			last = kMemorySize - 1;
+		}
+
+		for (UInt32 pc = first; pc <= last; ++pc)
+		{
+			if ((pc & 0x1) == 0)
+			{
+				mDecodeCache[decodeCacheIndex(static_cast<UShort>(pc))].mHandler = nullptr;
+			}
+		}
+
+		if (mJit)
+		{
+			mJit->invalidate(address, length);
+		}
+		if (mCompiled)
+		{
+			mCompiled->invalidate(address, length);
+		}
+	}
+
+	inline void Chip8Machine::execute()
+	{
+		// Fetch and decode, almost always straight from the cache.
+		const DecodedOp& op = fetchDecoded(mState.mPC);
+		const UChar writeLength = op.mWriteLength;
+
+		// Execute.
+		// Return code will let us know if we need to increment the PC.
+		if (op.mHandler(mState, op) == EIncrementPC::Yes)
+		{
+			incrementPC(mState);
+		}
+
+		// Self modifying code, drop anything decoded from the bytes just written.
+		if (writeLength != 0)
+		{
+			invalidateDecodeCache(mState.mI, writeLength);
+		}
+		++mState.mCycleCount;
+	}
+
+	void Chip8Machine::step()
+	{
+		execute();
+	}
+
+	UInt32 Chip8Machine::run(const UInt32 instructionCount)
+	{
+		if (mCompiled)
+		{
+			return runCompiled(instructionCount);
+		}
+		if (mJit)
+		{
+			return runJit(instructionCount);
+		}
+
+#if defined CHIP8_THREADED_DISPATCH
+		return runThreaded(instructionCount);
+#else
+		for (UInt32 i = 0; i < instructionCount; ++i)
+		{
+			execute();
+		}
+		return instructionCount;
+#endif
+	}
+
+	// Whole blocks run as native code, whatever the budget can't cover as a whole block is interpreted.
+	UInt32 Chip8Machine::runJit(const UInt32 instructionCount)
+	{
+		UInt32 remaining = instructionCount;
+		while (remaining != 0)
+		{
+			const JitBlock* block = mJit->getBlock(mState, mState.mPC);
+			if (block && (block->mInstructionCount <= remaining))
+			{
+				mState.mRunEndCycle = mState.mCycleCount + remaining;
+				const UInt32 left = mJit->run(mState, *block, remaining);
+				mState.mCycleCount += remaining - left;
+				remaining = left;
+
+				// Self modifying code, same as execute().
+				const UChar writeLength = mJit->takePendingWrite();
+				if (writeLength != 0)
+				{
+					invalidateDecodeCache(mState.mI, writeLength);
+				}
+			}
+			else
+			{
+				execute();
+				--remaining;
+			}
+		}
+		return instructionCount;
+	}
+
+	// Compiled blocks run back to back, anything the compiled code can't take is interpreted an instruction at a time.
+	UInt32 Chip8Machine::runCompiled(const UInt32 instructionCount)
+	{
+		UInt32 remaining = instructionCount;
+		while (remaining != 0)
+		{
+			UInt32 writeLength = 0;
+			mState.mRunEndCycle = mState.mCycleCount + remaining;
+			const UInt32 left = mCompiled->run(mState, remaining, writeLength);
+			mState.mCycleCount += remaining - left;
+
+			if (writeLength != 0)
+			{
+				// Self modifying code, same as execute().
+				invalidateDecodeCache(mState.mI, writeLength);
+				remaining = left;
+			}
+			else if (left == remaining)
+			{
+				execute();
+				remaining = left - 1;
+			}
+			else
+			{
+				remaining = left;
+			}
+		}
+		return instructionCount;
+	}
+
+	// Threaded interpreter.
+	// Each instruction body ends in its own dispatch, so every body gets its own indirect branch (and its own prediction history)
+	// instead of sharing one call site, there are no calls or return codes for the common instructions and PC lives in a local
+	// that is only written back around the handlers that need it.
+	// Uses GCC/Clang computed goto, anything else falls back to a switch over the same bodies.
+	UInt32 Chip8Machine::runThreaded(const UInt32 instructionCount)
+	{
+		Chip8State& state = mState;
+		UChar* const v = state.mV;
+		UInt32 remaining = instructionCount;
+		UShort pc = state.mPC;
+		const DecodedOp* op;
+
+#if defined __GNUC__
+		static const void* const kDispatch[EOpId::Max] =
+		{
+			&&OpCode00E0, &&OpCode00EE, &&OpCodeCall, &&OpCode1NNN, &&OpCode2NNN, &&OpCode3XNN, &&OpCode4XNN, &&OpCode5XY0,
+			&&OpCode6XNN, &&OpCode7XNN, &&OpCode8XY0, &&OpCode8XY1, &&OpCode8XY2, &&OpCode8XY3, &&OpCode8XY4, &&OpCode8XY5,
+			&&OpCode8XY6, &&OpCode8XY7, &&OpCode8XYE, &&OpCode9XY0, &&OpCodeANNN, &&OpCodeBNNN, &&OpCodeCall, &&OpCodeCall,
+			&&OpCodeCall, &&OpCodeCall, &&OpCodeFX07, &&OpCodeCall, &&OpCodeFX15, &&OpCodeFX18, &&OpCodeFX1E, &&OpCodeFX29,
+			&&OpCodeStore, &&OpCodeStore, &&OpCodeCall, &&OpCodeCall
+		};
+#define CHIP8_OP(name) name:
+#define CHIP8_SHARED_OP(name) name:
+#define CHIP8_DISPATCH() \
+		if (remaining == 0) goto Done; \
+		--remaining; \
+		op = &fetchDecoded(pc); \
+		goto *kDispatch[op->mOpId]
+		CHIP8_DISPATCH();
+#else
+#define CHIP8_OP(name) case EOpId::name:
+#define CHIP8_SHARED_OP(name)
+#define CHIP8_DISPATCH() continue
+		while (remaining != 0)
+		{
+			--remaining;
+			op = &fetchDecoded(pc);
+			switch (op->mOpId)
+			{
+				case EOpId::OpCode0NNN:
+				case EOpId::OpCodeCXNN:
+				case EOpId::OpCodeDXYN:
+				case EOpId::OpCodeEX9E:
+				case EOpId::OpCodeEXA1:
+				case EOpId::OpCodeFX0A:
+				case EOpId::OpCodeFX65:
+				case EOpId::OpCodeInvalid:
+#endif
+		// Anything without a body of its own goes through its handler.
+		CHIP8_SHARED_OP(OpCodeCall)
+		{
+			state.mPC = pc;
+			if (op->mHandler(state, *op) == EIncrementPC::Yes)
+			{
+				state.mPC += sizeof(UShort);
+			}
+			pc = state.mPC;
+			CHIP8_DISPATCH();
+		}
+
+#if !defined __GNUC__
+				case EOpId::OpCodeFX33:
+				case EOpId::OpCodeFX55:
+#endif
+		// Writes to memory, may have written over code.
+		CHIP8_SHARED_OP(OpCodeStore)
+		{
+			const UChar writeLength = op->mWriteLength;
+			op->mHandler(state, *op);
+			pc += sizeof(UShort);
+			invalidateDecodeCache(state.mI, writeLength);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCode00E0)
+		{
+			cls(state);
+			state.mDirtyRows = kGFXAllRows;
+			pc += sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCode00EE)
+		{
+			pc = state.mStack[--state.mSP] + sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCode1NNN)
+		{
+			pc = op->mNNN;
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCode2NNN)
+		{
+			state.mStack[state.mSP++] = pc;
+			pc = op->mNNN;
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCode3XNN)
+		{
+			pc += (v[op->mX] == op->mNN) ? 2 * sizeof(UShort) : sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCode4XNN)
+		{
+			pc += (v[op->mX] != op->mNN) ? 2 * sizeof(UShort) : sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCode5XY0)
+		{
+			pc += (v[op->mX] == v[op->mY]) ? 2 * sizeof(UShort) : sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCode6XNN)
+		{
+			v[op->mX] = op->mNN;
+			pc += sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCode7XNN)
+		{
+			v[op->mX] += op->mNN;
+			pc += sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCode8XY0)
+		{
+			v[op->mX] = v[op->mY];
+			pc += sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCode8XY1)
+		{
+			v[op->mX] |= v[op->mY];
+			pc += sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCode8XY2)
+		{
+			v[op->mX] &= v[op->mY];
+			pc += sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCode8XY3)
+		{
+			v[op->mX] ^= v[op->mY];
+			pc += sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCode8XY4)
+		{
+			addToRegister(state, v[op->mX], v[op->mY], ESetFlowRegister::Yes);
+			pc += sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCode8XY5)
+		{
+			subtractFromRegister(state, v[op->mX], v[op->mY], ESetFlowRegister::Yes);
+			pc += sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCode8XY6)
+		{
+			opCode8XY6(state, *op);
+			pc += sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCode8XY7)
+		{
+			opCode8XY7(state, *op);
+			pc += sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCode8XYE)
+		{
+			opCode8XYE(state, *op);
+			pc += sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCode9XY0)
+		{
+			pc += (v[op->mX] != v[op->mY]) ? 2 * sizeof(UShort) : sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCodeANNN)
+		{
+			state.mI = op->mNNN;
+			pc += sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCodeBNNN)
+		{
+			pc = v[0] + op->mNNN + sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		// The cycle count is only added up once the run is over, this instruction is remaining + 1 from the end of it.
+		CHIP8_OP(OpCodeFX07)
+		{
+			syncTimers(state, state.mCycleCount + (instructionCount - remaining - 1));
+			v[op->mX] = state.mDelayTimer;
+			pc += sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCodeFX15)
+		{
+			syncTimers(state, state.mCycleCount + (instructionCount - remaining - 1));
+			state.mDelayTimer = v[op->mX];
+			pc += sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCodeFX18)
+		{
+			syncTimers(state, state.mCycleCount + (instructionCount - remaining - 1));
+			state.mSoundTimer = v[op->mX];
+			pc += sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCodeFX1E)
+		{
+			state.mI += v[op->mX];
+			pc += sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+		CHIP8_OP(OpCodeFX29)
+		{
+			opCodeFX29(state, *op);
+			pc += sizeof(UShort);
+			CHIP8_DISPATCH();
+		}
+
+#if defined __GNUC__
+	Done:
+#else
+			}
+		}
+#endif
+#undef CHIP8_OP
+#undef CHIP8_SHARED_OP
+#undef CHIP8_DISPATCH
+
+		state.mPC = pc;
+		state.mCycleCount += instructionCount;
+		return instructionCount;
+	}
+
+	void Chip8Machine::tickTimers()
+	{
+		if (mState.mInstructionsPerTimerTick != 0)
+		{
+			return;
+		}
+
+		if (mState.mDelayTimer > 0)
+		{
+			--mState.mDelayTimer;
+		}
+
+		if (mState.mSoundTimer > 0)
+		{
+			--mState.mSoundTimer;
+		}
+	}
+
+	void Chip8Machine::setRandSeed(const UInt64 seed)
+	{
+		seedRand(mState, seed);
+	}
+
+	void Chip8Machine::setInstructionsPerTimerTick(const UInt32 instructionsPerTick)
+	{
+		// The timers carry on from wherever they had got to.
+		syncTimers(mState, mState.mCycleCount);
+		mState.mInstructionsPerTimerTick = instructionsPerTick;
+		mState.mTimerCycle = mState.mCycleCount;
+
+		// Translated code reads and writes the timers inline unless they follow the instruction count.
+		if (mJit)
+		{
+			mJit->invalidate();
+		}
+	}
+
+	UChar Chip8Machine::getDelayTimer() const
+	{
+		const UInt64 ticks = getTimerTicksDue(mState, mState.mCycleCount);
+		return (ticks < mState.mDelayTimer) ? static_cast<UChar>(mState.mDelayTimer - ticks) : 0;
+	}
+
+	UChar Chip8Machine::getSoundTimer() const
+	{
+		const UInt64 ticks = getTimerTicksDue(mState, mState.mCycleCount);
+		return (ticks < mState.mSoundTimer) ? static_cast<UChar>(mState.mSoundTimer - ticks) : 0;
+	}
+
+} // namespace SynchingFeeling
\ No newline at end of file
@@ -0,0 +1,248 @@
+#pragma once
+
+#include "EmuTypes.h"
+
+namespace SynchingFeeling
+{
+	// Machine consts
+	static const Int32 kGFXWidth = 64;								// pixels in one screen's width
+	static const Int32 kGFXHeight = 32;								// pixels in one screen's height
+	static const Int32 kGFXSpriteWidth = 8;							// pixels in one sprite row, one byte
+	static const UInt32 kGFXAllRows = 0xFFFFFFFF;					// Dirty row mask with every row set, one bit per row
+	static const UInt32 kMemorySize = 1024 * 4;						// 4KiB memory
+	static const UInt32 kRegisterCount = 16;						// V0-VF
+	static const UInt32 kStackSize = 16;							// Nested subroutine depth
+	static const UShort kPCStart = 0x200;							// PC start pos in memory
+	static const UInt32 kDecodeCacheSize = (kMemorySize - kPCStart) / 2;	// One entry per aligned instruction in 0x200-0xFFF
+
+	// Should we increment PC?
+	namespace EIncrementPC
+	{
+		enum Type
+		{
+			Yes,
+			No
+		};
+	};
+
+	// What happens to the pixels of a sprite drawn across the edge of the screen.
+	namespace ESpriteEdge
+	{
+		enum Type
+		{
+			Clip,		// Dropped
+			Wrap		// Drawn from the opposite edge
+		};
+	};
+
+	// Everything a single VM owns.
+	// Kept as plain data so a machine can be copied, snapshotted or restored wholesale.
+	struct Chip8State
+	{
+		UChar mMemory[kMemorySize];									// 4KiB memory
+		UChar mV[kRegisterCount];									// Registers V0-VE (+carry)
+		UShort mI;													// Index reg (0x000-0xFFF)
+		UShort mPC;													// Program Counter (0x000-0xFFF)
+		UShort mSP;													// Stack Pointer (0x000-0xFFF)
+		UShort mStack[kStackSize];									// Stack
+		UInt64 mGfx[kGFXHeight];									// One word per row, bit 63 is the leftmost pixel
+		UChar mDelayTimer;											// 60hz countdown - delay, as of mTimerCycle when the timers follow the instruction count
+		UChar mSoundTimer;											// 60hz countdown - sound, likewise
+		UShort mKeys;												// Keys held down, bit N for key N
+		UInt32 mDirtyRows;											// Rows changed since the last present, bit 0 is the top row
+		UInt64 mCycleCount;											// Instructions executed since reset
+		UChar mSpriteEdge;											// ESpriteEdge::Type, kept over reset
+		UInt32 mInstructionsPerTimerTick;							// Timers tick on every multiple of this in mCycleCount, 0 if the host ticks them. Kept over reset
+		UInt64 mTimerCycle;											// The cycle count the timers were last brought up to
+		UInt64 mRunEndCycle;										// mCycleCount once the current run's budget is used up, for code that only counts its budget down
+		UInt64 mRandState;											// CXNN's generator (PCG32), restoring a snapshot replays the same numbers
+		UInt64 mRandSeed;											// What mRandState starts from, kept over reset
+	};
+
+	// Timer ticks due between the cycle the timers were last brought up to and cycle, always 0 while the host ticks them.
+	inline UInt64 getTimerTicksDue(const Chip8State& state, const UInt64 cycle)
+	{
+		const UInt32 perTick = state.mInstructionsPerTimerTick;
+		return (perTick == 0) ? 0 : ((cycle / perTick) - (state.mTimerCycle / perTick));
+	}
+
+	// Brings both timers up to cycle, the instruction about to run, before FX07, FX15 or FX18 touch them.
+	// The timers are only ever worked out here, nothing ticks them while the program runs.
+	inline void syncTimers(Chip8State& state, const UInt64 cycle)
+	{
+		if (state.mInstructionsPerTimerTick == 0)
+		{
+			return;
+		}
+
+		const UInt64 ticks = getTimerTicksDue(state, cycle);
+		state.mDelayTimer = (ticks < state.mDelayTimer) ? static_cast<UChar>(state.mDelayTimer - ticks) : 0;
+		state.mSoundTimer = (ticks < state.mSoundTimer) ? static_cast<UChar>(state.mSoundTimer - ticks) : 0;
+		state.mTimerCycle = cycle;
+	}
+
+	// Every distinct instruction, what an opcode decodes to.
+	namespace EOpId
+	{
+		enum Type
+		{
+			OpCode00E0,
+			OpCode00EE,
+			OpCode0NNN,
+			OpCode1NNN,
+			OpCode2NNN,
+			OpCode3XNN,
+			OpCode4XNN,
+			OpCode5XY0,
+			OpCode6XNN,
+			OpCode7XNN,
+			OpCode8XY0,
+			OpCode8XY1,
+			OpCode8XY2,
+			OpCode8XY3,
+			OpCode8XY4,
+			OpCode8XY5,
+			OpCode8XY6,
+			OpCode8XY7,
+			OpCode8XYE,
+			OpCode9XY0,
+			OpCodeANNN,
+			OpCodeBNNN,
+			OpCodeCXNN,
+			OpCodeDXYN,
+			OpCodeEX9E,
+			OpCodeEXA1,
+			OpCodeFX07,
+			OpCodeFX0A,
+			OpCodeFX15,
+			OpCodeFX18,
+			OpCodeFX1E,
+			OpCodeFX29,
+			OpCodeFX33,
+			OpCodeFX55,
+			OpCodeFX65,
+			OpCodeInvalid,
+			Max
+		};
+	};
+
+	struct DecodedOp;
+	class Chip8Jit;
+	class Chip8CompiledCode;
+	struct CompiledProgram;
+	typedef EIncrementPC::Type(*OpHandler)(Chip8State&, const DecodedOp&);
+
+	// An instruction decoded once, resolved to the handler for its exact opcode with the operand fields already extracted.
+	struct DecodedOp
+	{
+		OpHandler mHandler;											// nullptr until decoded
+		UShort mOpCode;												// Raw opcode
+		UShort mNNN;												// Address
+		UChar mX;													// Register X
+		UChar mY;													// Register Y
+		UChar mN;													// Nibble
+		UChar mNN;													// Byte
+		UChar mWriteLength;											// Bytes written from I, for FX33 and FX55
+		UChar mOpId;												// EOpId::Type
+	};
+
+	// Decodes a raw opcode, any opcode that isn't recognised resolves to a handler that reports it.
+	DecodedOp decodeOpCode(const UShort opCode);
+
+	// A single, self-contained CHIP-8 VM.
+	// There is no shared or hidden state, so any number of machines can run side by side, one per thread, without locking.
+	// The machine knows nothing of wall time, windows or input devices; the host drives it through step/run and tickTimers,
+	// or has the timers follow the instruction count instead.
+	class Chip8Machine
+	{
+	public:
+		Chip8Machine();
+		~Chip8Machine();
+
+		// Clears all state and loads the font, ready for a program.
+		void reset();
+
+		// Program memory (0x200 onwards) for hosts that want to read a ROM straight into the machine.
+		// Handing out write access drops every decoded instruction.
+		char* getProgramMemory();
+		UInt32 getProgramMemorySize() const;
+
+		// Copies a ROM image into program memory, truncating anything past the end of memory.
+		void loadProgram(const UChar* program, const UInt32 size);
+
+		// Fetch, decode and execute a single instruction.
+		void step();
+
+		// Execute a number of instructions back to back, returns how many were executed.
+		UInt32 run(const UInt32 instructionCount);
+
+		// Runs translated native code rather than interpreting, where the host supports it.
+		// Returns whether the JIT is now in use, only step() still interprets.
+		bool setJitEnabled(const bool enabled);
+		bool isJitEnabled() const { return mJit != nullptr; }
+
+		// Runs a ROM compiled ahead of time by chip8aot, nullptr goes back to interpreting.
+		// Compiled code only runs while memory still holds the ROM it was compiled from, it takes priority over the JIT.
+		void setCompiledProgram(const CompiledProgram* program);
+
+		// Clip (the default) or wrap sprites drawn across the edge of the screen.
+		void setSpriteEdge(const ESpriteEdge::Type edge) { mState.mSpriteEdge = static_cast<UChar>(edge); }
+		ESpriteEdge::Type getSpriteEdge() const { return static_cast<ESpriteEdge::Type>(mState.mSpriteEdge); }
+
+		// Seeds CXNN's generator and restarts it, the same seed gives the same numbers on any host or thread. Machines start with 0.
+		void setRandSeed(const UInt64 seed);
+		UInt64 getRandSeed() const { return mState.mRandSeed; }
+
+		// Count the delay and sound timers down, should be called at 60Hz. Does nothing while they follow the instruction count.
+		void tickTimers();
+
+		// Ticks the timers once every instructionsPerTick instructions rather than when the host says, 0 goes back to tickTimers.
+		// The ratio is fixed, so runs are the same however fast they go. Nothing is done per instruction, the timers are
+		// worked out when the program reads or writes them.
+		void setInstructionsPerTimerTick(const UInt32 instructionsPerTick);
+		UInt32 getInstructionsPerTimerTick() const { return mState.mInstructionsPerTimerTick; }
+
+		// Every key held down at once, bit N for key N.
+		void setKeys(const UShort keys) { mState.mKeys = keys; }
+		UShort getKeys() const { return mState.mKeys; }
+
+		const UInt64* getGfx() const { return mState.mGfx; }
+		bool getDrawFlag() const { return mState.mDirtyRows != 0; }
+		UInt32 getDirtyRows() const { return mState.mDirtyRows; }
+		void clearDrawFlag() { mState.mDirtyRows = 0; }
+
+		UChar getDelayTimer() const;
+		UChar getSoundTimer() const;
+		bool isSoundActive() const { return getSoundTimer() > 0; }
+		UInt64 getCycleCount() const { return mState.mCycleCount; }
+
+		const Chip8State& getState() const { return mState; }
+		void setState(const Chip8State& state);
+
+	private:
+		Chip8Machine(const Chip8Machine&);
+		Chip8Machine& operator=(const Chip8Machine&);
+
+		void execute();
+		UInt32 runThreaded(const UInt32 instructionCount);
+		UInt32 runJit(const UInt32 instructionCount);
+		UInt32 runCompiled(const UInt32 instructionCount);
+		const DecodedOp& fetchDecoded(const UShort pc);
+		const DecodedOp& decode(const UShort pc);
+		void invalidateDecodeCache();
+		void invalidateDecodeCache(const UInt32 address, const UInt32 length);
+
+		Chip8State mState;
+
+		// Decoded instructions for 0x200-0xFFF keyed by PC, only FX33/FX55 writes into code ever drop entries.
+		// Not part of the state, it is rebuilt lazily from memory.
+		DecodedOp mDecodeCache[kDecodeCacheSize];
+		DecodedOp mUncachedOp;
+
+		// Owned, only while the JIT is enabled.
+		Chip8Jit* mJit;
+
+		// Owned, only while a compiled program is attached.
+		Chip8CompiledCode* mCompiled;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include "Phosphor.h"
+
+#include <string.h>
+
+#include "PixelExpand.h"
+
+// Follows the instruction set the core is built for, as the pixel expansion kernels do.
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CHIP8_PHOSPHOR_SSE2
+#endif
+
+namespace SynchingFeeling
+{
+	namespace
+	{
+		static const UInt32 kFullIntensity = 0xFF;
+
+		// One channel of a colour, shift picks which.
+		inline UInt32 blendChannel(const UInt32 foreground, const UInt32 background, const UInt32 intensity, const UInt32 shift)
+		{
+			const Int32 from = static_cast<Int32>((background >> shift) & 0xFF);
+			const Int32 to = static_cast<Int32>((foreground >> shift) & 0xFF);
+			return static_cast<UInt32>(from + (((to - from) * static_cast<Int32>(intensity)) / static_cast<Int32>(kFullIntensity))) << shift;
+		}
+
+	} // namespace
+
+	Phosphor::Phosphor()
+	{
+		setColours(kDefaultForegroundColour, kDefaultBackgroundColour);
+		configure(0);
+	}
+
+	void Phosphor::configure(const UInt32 decay)
+	{
+		mDecay = (decay > 255) ? 255 : decay;
+		mFadingRows = 0;
+		memset(mIntensity, 0, sizeof(mIntensity));
+	}
+
+	void Phosphor::setColours(const UInt32 foreground, const UInt32 background)
+	{
+		for (UInt32 intensity = 0; intensity <= kFullIntensity; ++intensity)
+		{
+			mPalette[intensity] = blendChannel(foreground, background, intensity, 24)
+				| blendChannel(foreground, background, intensity, 16)
+				| blendChannel(foreground, background, intensity, 8)
+				| blendChannel(foreground, background, intensity, 0);
+		}
+	}
+
+	UInt32 Phosphor::update(const UInt64* gfx, const Int32 width, const Int32 height, const UInt32 dirtyRows)
+	{
+		// Rows that neither changed nor are fading already match the frame, 0xFF where set and 0 where clear.
+		const UInt32 rows = dirtyRows | mFadingRows;
+		UInt32 changedRows = 0;
+		for (Int32 y = 0; y < height; ++y)
+		{
+			if (((rows >> y) & 1) == 0)
+			{
+				continue;
+			}
+
+			bool fading = false;
+			if (updateRow(gfx[y], width, mIntensity[y], fading))
+			{
+				changedRows |= 1u << y;
+			}
+
+			if (fading)
+			{
+				mFadingRows |= 1u << y;
+			}
+			else
+			{
+				mFadingRows &= ~(1u << y);
+			}
+		}
+		return changedRows;
+	}
+
+	bool Phosphor::updateRow(const UInt64 row, const Int32 width, UChar* intensities, bool& outFading) const
+	{
+		Int32 x = 0;
+		bool changed = false;
+
+#if defined CHIP8_PHOSPHOR_SSE2
+		// 16 pixels at a time, each byte of the row is spread over 8 lanes and each lane tests its own bit.
+		const __m128i bitSelect = _mm_set_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+		const __m128i decay = _mm_set1_epi16(static_cast<short>(mDecay));
+		const __m128i zero = _mm_setzero_si128();
+		__m128i changedLanes = zero;
+		__m128i fadingLanes = zero;
+		for (; x + 16 <= width; x += 16)
+		{
+			const UInt64 bits = (row >> (48 - x)) & 0xFFFF;
+			const __m128i bytes = _mm_set_epi64x(static_cast<long long>((bits & 0xFF) * 0x0101010101010101ull), static_cast<long long>((bits >> 8) * 0x0101010101010101ull));
+			const __m128i lit = _mm_cmpeq_epi8(_mm_and_si128(bytes, bitSelect), bitSelect);
+
+			const __m128i previous = _mm_loadu_si128(reinterpret_cast<const __m128i*>(intensities + x));
+			const __m128i low = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(previous, zero), decay), 8);
+			const __m128i high = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(previous, zero), decay), 8);
+			const __m128i next = _mm_or_si128(lit, _mm_packus_epi16(low, high));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(intensities + x), next);
+
+			changedLanes = _mm_or_si128(changedLanes, _mm_xor_si128(next, previous));
+			fadingLanes = _mm_or_si128(fadingLanes, _mm_andnot_si128(lit, next));
+		}
+		changed = (_mm_movemask_epi8(_mm_cmpeq_epi8(changedLanes, zero)) != 0xFFFF);
+		outFading = (_mm_movemask_epi8(_mm_cmpeq_epi8(fadingLanes, zero)) != 0xFFFF);
+#endif
+
+		for (; x < width; ++x)
+		{
+			const UInt32 previous = intensities[x];
+			const bool lit = ((row << x) >> 63) != 0;
+			const UInt32 next = (lit) ? kFullIntensity : ((previous * mDecay) >> 8);
+			intensities[x] = static_cast<UChar>(next);
+			changed = changed || (next != previous);
+			outFading = outFading || (!lit && next != 0);
+		}
+		return changed;
+	}
+
+	void Phosphor::writeRowsRGBA32(const Int32 width, const Int32 firstRow, const Int32 endRow, const UInt32 scale, UChar* out, const Int32 pitch) const
+	{
+		const UInt32 rowBytes = static_cast<UInt32>(width) * scale * sizeof(UInt32);
+		for (Int32 y = firstRow; y < endRow; ++y)
+		{
+			// The first output row of each block is written pixel by pixel and copied down.
+			UChar* block = out + ((y - firstRow) * static_cast<Int32>(scale) * pitch);
+			UInt32* pixel = reinterpret_cast<UInt32*>(block);
+			for (Int32 x = 0; x < width; ++x)
+			{
+				const UInt32 colour = mPalette[mIntensity[y][x]];
+				for (UInt32 i = 0; i < scale; ++i)
+				{
+					*pixel++ = colour;
+				}
+			}
+
+			for (UInt32 r = 1; r < scale; ++r)
+			{
+				memcpy(block + (r * pitch), block, rowBytes);
+			}
+		}
+	}
+
+} // namespace SynchingFeeling
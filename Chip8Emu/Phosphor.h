@@ -0,0 +1,46 @@
+#pragma once
+
+#include "EmuTypes.h"
+
+namespace SynchingFeeling
+{
+	static const UInt32 kDefaultPhosphorDecay = 192;				// A cleared pixel keeps 3/4 of its intensity each present
+	static const Int32 kPhosphorMaxWidth = 64;						// One word per row
+	static const Int32 kPhosphorMaxHeight = 32;						// One bit per row in the dirty row mask
+
+	// Phosphor persistence. Cleared pixels fade out over a few presents rather than vanishing, which hides the flicker of XOR drawn sprites.
+	// It advances once per present, so its cost follows the display rate however often the game draws,
+	// and only rows that changed or are still fading are touched, 16 pixels at a time.
+	class Phosphor
+	{
+	public:
+		Phosphor();
+
+		// decay is how much of a cleared pixel's intensity is kept each present, out of 256. 0 turns the stage off.
+		void configure(const UInt32 decay);
+		bool isEnabled() const { return mDecay != 0; }
+
+		// True while a cleared pixel hasn't faded out yet, so presents are still needed when nothing is drawn.
+		bool isFading() const { return mFadingRows != 0; }
+
+		// Colours at full and zero intensity, 0xAARRGGBB, the ones in between are blended.
+		void setColours(const UInt32 foreground, const UInt32 background);
+
+		// Advances one present, set pixels go to full intensity and cleared ones fade.
+		// Frames are one word per row, leftmost pixel in the top bit. Returns the rows whose colours changed.
+		UInt32 update(const UInt64* gfx, const Int32 width, const Int32 height, const UInt32 dirtyRows);
+
+		// Writes rows [firstRow, endRow) as RGBA32, each pixel a scale x scale block.
+		// out is the output row for firstRow (firstRow * scale in the whole image), pitch is in bytes.
+		void writeRowsRGBA32(const Int32 width, const Int32 firstRow, const Int32 endRow, const UInt32 scale, UChar* out, const Int32 pitch) const;
+
+	private:
+		// Updates one row, true if any of its intensities changed. outFading is set if any cleared pixel is still lit.
+		bool updateRow(const UInt64 row, const Int32 width, UChar* intensities, bool& outFading) const;
+
+		UChar mIntensity[kPhosphorMaxHeight][kPhosphorMaxWidth];	// 0xFF set, fading down to 0 once cleared
+		UInt32 mPalette[256];										// Colour of each intensity
+		UInt32 mDecay;
+		UInt32 mFadingRows;											// Rows with a pixel still fading
+	};
+}
@@ -0,0 +1,120 @@
+#include "PixelExpand.h"
+
+#include <string.h>
+
+// The kernel follows the instruction set the core is built for (CHIP8_ISA), x86-64 always has SSE2.
+#if defined __AVX2__
+#include <immintrin.h>
+#define CHIP8_EXPAND_AVX2
+#define CHIP8_EXPAND_SSE2
+#elif defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CHIP8_EXPAND_SSE2
+#endif
+
+namespace SynchingFeeling
+{
+	namespace
+	{
+		static const UInt32 kRGB24PixelSize = 3;
+		static const Int32 kRGB24NibblePixels = 4;
+
+		inline void writeRGB24(const UInt32 colour, UChar* out)
+		{
+			out[0] = static_cast<UChar>(colour >> 16);
+			out[1] = static_cast<UChar>(colour >> 8);
+			out[2] = static_cast<UChar>(colour);
+		}
+
+	} // namespace
+
+	void setPixelColours(PixelColours& outColours, const UInt32 foreground, const UInt32 background)
+	{
+		outColours.mForeground = foreground;
+		outColours.mBackground = background;
+
+		memset(outColours.mRGB24Nibbles, 0, sizeof(outColours.mRGB24Nibbles));
+		for (UInt32 nibble = 0; nibble < 16; ++nibble)
+		{
+			for (Int32 i = 0; i < kRGB24NibblePixels; ++i)
+			{
+				const bool set = ((nibble << i) & 0x8) != 0;
+				writeRGB24((set) ? foreground : background, &outColours.mRGB24Nibbles[nibble][i * kRGB24PixelSize]);
+			}
+		}
+	}
+
+	void expandRowRGBA32(const UInt64 row, const Int32 width, const PixelColours& colours, UInt32* out)
+	{
+		Int32 x = 0;
+
+		// A byte of the row at a time, each pixel's bit is tested in a lane of its own and picks its colour.
+#if defined CHIP8_EXPAND_AVX2
+		const __m256i bits = _mm256_setr_epi32(0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+		const __m256i foreground = _mm256_set1_epi32(static_cast<int>(colours.mForeground));
+		const __m256i background = _mm256_set1_epi32(static_cast<int>(colours.mBackground));
+		for (; x + 8 <= width; x += 8)
+		{
+			const __m256i byte = _mm256_set1_epi32(static_cast<int>((row >> (56 - x)) & 0xFF));
+			const __m256i set = _mm256_cmpeq_epi32(_mm256_and_si256(byte, bits), bits);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_blendv_epi8(background, foreground, set));
+		}
+#elif defined CHIP8_EXPAND_SSE2
+		const __m128i bitsLeft = _mm_setr_epi32(0x80, 0x40, 0x20, 0x10);
+		const __m128i bitsRight = _mm_setr_epi32(0x08, 0x04, 0x02, 0x01);
+		const __m128i foreground = _mm_set1_epi32(static_cast<int>(colours.mForeground));
+		const __m128i background = _mm_set1_epi32(static_cast<int>(colours.mBackground));
+		for (; x + 8 <= width; x += 8)
+		{
+			const __m128i byte = _mm_set1_epi32(static_cast<int>((row >> (56 - x)) & 0xFF));
+			const __m128i setLeft = _mm_cmpeq_epi32(_mm_and_si128(byte, bitsLeft), bitsLeft);
+			const __m128i setRight = _mm_cmpeq_epi32(_mm_and_si128(byte, bitsRight), bitsRight);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_or_si128(_mm_and_si128(setLeft, foreground), _mm_andnot_si128(setLeft, background)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x + 4), _mm_or_si128(_mm_and_si128(setRight, foreground), _mm_andnot_si128(setRight, background)));
+		}
+#endif
+
+		for (; x < width; ++x)
+		{
+			out[x] = ((row << x) >> 63) ? colours.mForeground : colours.mBackground;
+		}
+	}
+
+	void expandRowRGB24(const UInt64 row, const Int32 width, const PixelColours& colours, UChar* out)
+	{
+		Int32 x = 0;
+
+		// A nibble of the row at a time, straight from the table.
+#if defined CHIP8_EXPAND_SSE2
+		// Whole 16 byte entries are stored, the 4 bytes past each nibble's pixels are written over by the next.
+		// Stopping while two whole nibbles are left keeps them inside the row.
+		for (; x + 8 <= width; x += kRGB24NibblePixels)
+		{
+			const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(colours.mRGB24Nibbles[(row >> (60 - x)) & 0xF]));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + (x * kRGB24PixelSize)), pixels);
+		}
+#endif
+
+		for (; x + kRGB24NibblePixels <= width; x += kRGB24NibblePixels)
+		{
+			memcpy(out + (x * kRGB24PixelSize), colours.mRGB24Nibbles[(row >> (60 - x)) & 0xF], kRGB24NibblePixels * kRGB24PixelSize);
+		}
+
+		for (; x < width; ++x)
+		{
+			writeRGB24(((row << x) >> 63) ? colours.mForeground : colours.mBackground, out + (x * kRGB24PixelSize));
+		}
+	}
+
+	const char* getPixelExpandKernelName()
+	{
+#if defined CHIP8_EXPAND_AVX2
+		return "avx2";
+#elif defined CHIP8_EXPAND_SSE2
+		return "sse2";
+#else
+		return "scalar";
+#endif
+	}
+
+} // namespace SynchingFeeling
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "EmuTypes.h"
+
+namespace SynchingFeeling
+{
+	static const UInt32 kDefaultForegroundColour = 0xFFFFFFFF;		// 0xAARRGGBB, white
+	static const UInt32 kDefaultBackgroundColour = 0xFF000000;		// 0xAARRGGBB, black
+
+	// Colours set pixels and clear pixels expand to, with the tables the kernels build from them.
+	struct PixelColours
+	{
+		UInt32 mForeground;											// 0xAARRGGBB
+		UInt32 mBackground;											// 0xAARRGGBB
+		UChar mRGB24Nibbles[16][16];								// Four RGB24 pixels per nibble of a row, padded to 16 bytes
+	};
+
+	void setPixelColours(PixelColours& outColours, const UInt32 foreground, const UInt32 background);
+
+	// Expand one framebuffer row (one word, leftmost pixel in the top bit) into width pixels, width is at most 64.
+	// RGBA32 writes one 0xAARRGGBB word per pixel, RGB24 three bytes per pixel, red first.
+	void expandRowRGBA32(const UInt64 row, const Int32 width, const PixelColours& colours, UInt32* out);
+	void expandRowRGB24(const UInt64 row, const Int32 width, const PixelColours& colours, UChar* out);
+
+	// Which kernel the expansions were built with: avx2, sse2 or scalar.
+	const char* getPixelExpandKernelName();
+}
@@ -68,6 +68,15 @@ namespace SynchingFeeling
 		};
 		static const Int32 kKeyMappingsSize = (sizeof(kKeyMappings) / sizeof(Int32));
 
+		static UInt16 gForeground565 = 0xFFFF;
+		static UInt16 gBackground565 = 0x0000;
+
+		// 0xAARRGGBB down to the screen's 16 bit 5:6:5.
+		UInt16 toRGB565(const UInt32 colour)
+		{
+			return static_cast<UInt16>(((colour >> 8) & 0xF800) | ((colour >> 5) & 0x07E0) | ((colour >> 3) & 0x001F));
+		}
+
 		static File gFile;
 		static Adafruit_TFTLCD gTft(LCD_CS, LCD_CD, LCD_WR, LCD_RD, LCD_RESET);
 		static Int32 gLetterboxWidth;
@@ -151,19 +160,55 @@ namespace SynchingFeeling
 		// Do nothing.
 	}
 
-	void platformDraw(const void* gfx, const Int32 width, const Int32 height)
+	void platformRenderInit()
+	{
+		// Do nothing, the screen is ready once platformInit is done.
+	}
+
+	void platformRenderDeInit()
+	{
+		// Do nothing.
+	}
+
+	void platformSetColours(const UInt32 foreground, const UInt32 background)
+	{
+		gForeground565 = toRGB565(foreground);
+		gBackground565 = toRGB565(background);
+	}
+
+	void platformSetUpscale(const EUpscaleFilter::Type, const UInt32)
 	{
-		for (Int32 x = 0; x < width; ++x)
+		// Do nothing, the screen is drawn a pixel at a time.
+	}
+
+	void platformSetPhosphor(const UInt32)
+	{
+		// Do nothing, there isn't the memory for an intensity per pixel.
+	}
+
+	bool platformIsFading()
+	{
+		return false;
+	}
+
+	void platformDraw(const UInt64* gfx, const Int32 width, const Int32 height, const UInt32 dirtyRows)
+	{
+		// Only rows changed since the last present are redrawn.
+		for (Int32 y = 0; y < height; ++y)
 		{
-			for (Int32 y = 0; y < height; ++y)
+			if (((dirtyRows >> y) & 1) == 0)
 			{
-				//const UChar* currentByte = reinterpret_cast<const UChar>(gfx)[x + (y * gLetterboxWidth)];
-				gTft.fillRect(x, y, 1, 1, 0xFFFF);
+				continue;
+			}
+			for (Int32 x = 0; x < width; ++x)
+			{
+				const bool pixelSet = ((gfx[y] << x) >> 63) != 0;
+				gTft.fillRect(x, y, 1, 1, pixelSet ? gForeground565 : gBackground565);
 			}
 		}
 	}
 
-	bool platformPollInput(UChar& inOutKeyPressed, Char& inOutShouldUpdateCycleRate)
+	bool platformPollInput(UShort& inOutKeys, Char& inOutShouldUpdateCycleRate)
 	{
 		//TODO:
 		//val = digitalRead(inPin); 
@@ -171,17 +216,13 @@ namespace SynchingFeeling
 		return false;
 	}
 
-	void platformUpdateAudio()
-	{
-		// do nothing
-	}
-
-	void platformPlaySound()
+	void platformPlaySound(const UInt64)
 	{
+		// The pin drives a buzzer, it sounds as soon as it's set.
 		digitalWrite(kAudioPin, HIGH);
 	}
 
-	void platformStopSound()
+	void platformStopSound(const UInt64)
 	{
 		digitalWrite(kAudioPin, LOW);
 	}
@@ -205,6 +246,57 @@ namespace SynchingFeeling
 		return false;
 	}
 
+	UInt32 platformGetTicksUntilUpdate(const UInt32 ticksIntoYield, const UInt32 yieldTimeMS)
+	{
+		// Not started yet, the first platformCanUpdate starts it.
+		if (ticksIntoYield == 0)
+		{
+			return 0;
+		}
+
+		const UInt32 elapsed = millis() - ticksIntoYield;
+		return (elapsed >= yieldTimeMS) ? 0 : (yieldTimeMS - elapsed);
+	}
+
+	bool platformWaitForEvent(const UInt32 timeoutMS)
+	{
+		// Buttons aren't interrupt driven, so this just sleeps.
+		delay(timeoutMS);
+		return false;
+	}
+
+	void platformPumpEvents(const UInt32 timeoutMS)
+	{
+		// Nothing to pump, buttons are read as they're polled.
+		delay(timeoutMS);
+	}
+
+	UInt32 platformTakeDueUpdates(UpdateClock& inOutClock, const UInt32 maxUpdates)
+	{
+		return takeDueUpdates(inOutClock, platformGetTimeNS(), maxUpdates);
+	}
+
+	UInt64 platformGetNSUntilDue(const UpdateClock& clock)
+	{
+		return getNSUntilDue(clock, platformGetTimeNS());
+	}
+
+	UInt32 platformGetTicks()
+	{
+		return millis();
+	}
+
+	UInt64 platformGetTimeNS()
+	{
+		// micros wraps every 71 minutes, so it's accumulated.
+		static UInt32 lastMicros = micros();
+		static UInt64 totalMicros = 0;
+		const UInt32 now = micros();
+		totalMicros += now - lastMicros;
+		lastMicros = now;
+		return totalMicros * 1000;
+	}
+
 	void platformLoadGame(const char* gameName, char* readBuffer, const UInt32 readSize)
 	{
 		gFile = SD.open("PONG2", FILE_READ);
@@ -218,9 +310,10 @@ namespace SynchingFeeling
 		gFile.close();
 	}
 
-	UChar platformRand(const UChar mask)
+	UInt64 platformGetRandSeed()
 	{
-		return random(mask);
+		// random was seeded from the floating analogue pin.
+		return (static_cast<UInt64>(random(0x7FFFFFFF)) << 32) | static_cast<UInt32>(random(0x7FFFFFFF));
 	}
 
 } // namespace SynchingFeeling
@@ -7,6 +7,8 @@
 
 #include <Arduino.h>
 #include "EmuTypes.h"
+#include "UpdateClock.h"
+#include "Upscale.h"
 
 namespace SynchingFeeling
 {
@@ -29,14 +31,26 @@ namespace SynchingFeeling
 	void log(const char* message);
 	void platformInit(const Int32 pixelsWidth, const Int32 pixelsHeight, const Int32 screenWidth, const Int32 screenHeight);
 	void platformDeInit();
-	void platformDraw(const void* gfx, const Int32 width, const Int32 height);
-	bool platformPollInput(UChar& inOutKeyPressed, Char& inOutShouldUpdateCycleRate);
-	void platformUpdateAudio();
-	void platformPlaySound();
-	void platformStopSound();
+	void platformRenderInit();
+	void platformRenderDeInit();
+	void platformSetColours(const UInt32 foreground, const UInt32 background);
+	void platformSetUpscale(const EUpscaleFilter::Type filter, const UInt32 nearestScale);
+	void platformSetPhosphor(const UInt32 decay);
+	bool platformIsFading();
+	void platformDraw(const UInt64* gfx, const Int32 width, const Int32 height, const UInt32 dirtyRows);
+	bool platformPollInput(UShort& inOutKeys, Char& inOutShouldUpdateCycleRate);
+	void platformPlaySound(const UInt64 timeNS);
+	void platformStopSound(const UInt64 timeNS);
 	bool platformCanUpdate(UInt32& inOutTicksIntoYield, const UInt32 yieldTimeMS);
+	UInt32 platformGetTicksUntilUpdate(const UInt32 ticksIntoYield, const UInt32 yieldTimeMS);
+	bool platformWaitForEvent(const UInt32 timeoutMS);
+	void platformPumpEvents(const UInt32 timeoutMS);
+	UInt32 platformTakeDueUpdates(UpdateClock& inOutClock, const UInt32 maxUpdates);
+	UInt64 platformGetNSUntilDue(const UpdateClock& clock);
+	UInt32 platformGetTicks();
+	UInt64 platformGetTimeNS();
 	void platformLoadGame(const char* gameName, char* readBuffer, const UInt32 readSize);
-	UChar platformRand(const UChar mask);
+	UInt64 platformGetRandSeed();
 }
 
 #endif // #ifdef ARDUINO
\ No newline at end of file
@@ -0,0 +1,332 @@
+#ifdef HEADLESS
+
+// Please note that the headless platform implementation has no window, audio device or input device.
+
+#include "Chip8Emu/PlatformHeadless.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace SynchingFeeling
+{
+	namespace
+	{
+		// Input script event types
+		namespace EInputEvent
+		{
+			enum Type
+			{
+				KeyDown,
+				KeyUp,
+				Quit
+			};
+		};
+
+		struct InputEvent
+		{
+			UInt32 mPoll;
+			EInputEvent::Type mType;
+			UChar mKey;
+		};
+
+		static const UInt64 kDefaultRandSeed = 0;
+		static const UInt32 kAllRows = 0xFFFFFFFF;	// Dirty row mask covering the whole frame
+
+		static UChar* gFrameBuffer;
+		static UInt32 gFrameBufferSize;
+		static bool gFrameBufferStale;
+		static UInt32 gFrameCount;
+		static UInt32 gPollCount;
+		static UInt32 gMaxPolls;
+		static vector<InputEvent> gInputEvents;
+		static size_t gNextInputEvent;
+		static UInt64 gRandSeed = kDefaultRandSeed;
+
+		bool parseInputEvent(const string& line, InputEvent& outEvent)
+		{
+			istringstream stream(line);
+			string type;
+			if (!(stream >> outEvent.mPoll >> type))
+			{
+				return false;
+			}
+
+			if (type == "quit")
+			{
+				outEvent.mType = EInputEvent::Quit;
+				outEvent.mKey = kInvalidKey;
+				return true;
+			}
+
+			UInt32 key = 0;
+			if (!(stream >> hex >> key) || key > 0xF)
+			{
+				return false;
+			}
+			outEvent.mKey = static_cast<UChar>(key);
+
+			if (type == "down")
+			{
+				outEvent.mType = EInputEvent::KeyDown;
+				return true;
+			}
+			if (type == "up")
+			{
+				outEvent.mType = EInputEvent::KeyUp;
+				return true;
+			}
+			return false;
+		}
+
+	} // namespace
+
+	void platformInit(const Int32, const Int32, const Int32, const Int32)
+	{
+		gFrameCount = 0;
+		gPollCount = 0;
+		gNextInputEvent = 0;
+	}
+
+	void platformDeInit()
+	{
+		// Do nothing, the frame buffer belongs to the caller.
+	}
+
+	void platformRenderInit()
+	{
+		gFrameBufferStale = true;
+	}
+
+	void platformRenderDeInit()
+	{
+		// do nothing
+	}
+
+	void platformSetColours(const UInt32, const UInt32)
+	{
+		// do nothing, frames are delivered as 0x00 or 0xFF per pixel
+	}
+
+	void platformSetUpscale(const EUpscaleFilter::Type, const UInt32)
+	{
+		// do nothing, frames are delivered at their own size
+	}
+
+	void platformSetPhosphor(const UInt32)
+	{
+		// do nothing, frames are delivered as set and clear pixels
+	}
+
+	bool platformIsFading()
+	{
+		return false;
+	}
+
+	void platformDraw(const UInt64* gfx, const Int32 width, const Int32 height, const UInt32 dirtyRows)
+	{
+		++gFrameCount;
+
+		const UInt32 frameSize = static_cast<UInt32>(width * height);
+		if (!gFrameBuffer || gFrameBufferSize < frameSize)
+		{
+			return;
+		}
+
+		// Rows that haven't changed since the last draw are already in the buffer.
+		const UInt32 rowsToExpand = (gFrameBufferStale) ? kAllRows : dirtyRows;
+		gFrameBufferStale = false;
+		for (Int32 y = 0; y < height; ++y)
+		{
+			if (((rowsToExpand >> y) & 1) == 0)
+			{
+				continue;
+			}
+			for (Int32 x = 0; x < width; ++x)
+			{
+				gFrameBuffer[x + (y * width)] = ((gfx[y] << x) >> 63) ? 0xFF : 0x00;
+			}
+		}
+	}
+
+	bool platformPollInput(UShort& inOutKeys, Char&)
+	{
+		const UInt32 poll = gPollCount++;
+		bool shouldQuit = (gMaxPolls != 0 && gPollCount >= gMaxPolls);
+
+		while (gNextInputEvent < gInputEvents.size() && gInputEvents[gNextInputEvent].mPoll <= poll)
+		{
+			const InputEvent& event = gInputEvents[gNextInputEvent++];
+			switch (event.mType)
+			{
+				case EInputEvent::KeyDown:
+					inOutKeys |= static_cast<UShort>(1 << event.mKey);
+					break;
+
+				case EInputEvent::KeyUp:
+					inOutKeys &= static_cast<UShort>(~(1 << event.mKey));
+					break;
+
+				case EInputEvent::Quit:
+					shouldQuit = true;
+					break;
+			}
+		}
+		return shouldQuit;
+	}
+
+	void platformPlaySound(const UInt64)
+	{
+		// do nothing
+	}
+
+	void platformStopSound(const UInt64)
+	{
+		// do nothing
+	}
+
+	bool platformCanUpdate(UInt32&, const UInt32)
+	{
+		// Uncapped, there is nobody watching.
+		return true;
+	}
+
+	UInt32 platformGetTicksUntilUpdate(const UInt32, const UInt32)
+	{
+		// Uncapped, always due.
+		return 0;
+	}
+
+	bool platformWaitForEvent(const UInt32)
+	{
+		// Never waits, input comes from the script.
+		return false;
+	}
+
+	void platformPumpEvents(const UInt32 timeoutMS)
+	{
+		// No window, input comes from the script as emulation polls.
+		this_thread::sleep_for(chrono::milliseconds(timeoutMS));
+	}
+
+	UInt32 platformTakeDueUpdates(UpdateClock&, const UInt32 maxUpdates)
+	{
+		// Uncapped, one update per take as platformCanUpdate.
+		return (maxUpdates != 0) ? 1 : 0;
+	}
+
+	UInt64 platformGetNSUntilDue(const UpdateClock&)
+	{
+		// Uncapped, always due.
+		return 0;
+	}
+
+	UInt32 platformGetTicks()
+	{
+		const auto sinceEpoch = chrono::steady_clock::now().time_since_epoch();
+		return static_cast<UInt32>(chrono::duration_cast<chrono::milliseconds>(sinceEpoch).count());
+	}
+
+	UInt64 platformGetTimeNS()
+	{
+		const auto sinceEpoch = chrono::steady_clock::now().time_since_epoch();
+		return static_cast<UInt64>(chrono::duration_cast<chrono::nanoseconds>(sinceEpoch).count());
+	}
+
+	void platformLoadGame(const char* gameName, char* readBuffer, const UInt32 readSize)
+	{
+		ifstream stream;
+		stream.open(gameName, ios::in | ios::binary);
+		if (!stream.is_open())
+		{
+			fail("Failed to open game: ", gameName);
+			return;
+		}
+
+		stream.seekg(0, ios::beg);
+		stream.read(readBuffer, readSize);
+		stream.close();
+	}
+
+	UInt64 platformGetRandSeed()
+	{
+		return gRandSeed;
+	}
+
+	void platformHeadlessSetFrameBuffer(UChar* frameBuffer, const UInt32 frameBufferSize)
+	{
+		gFrameBuffer = frameBuffer;
+		gFrameBufferSize = (frameBuffer) ? frameBufferSize : 0;
+		gFrameBufferStale = true;
+	}
+
+	bool platformHeadlessLoadInputScript(const char* scriptName)
+	{
+		gInputEvents.clear();
+		gNextInputEvent = 0;
+
+		ifstream stream(scriptName);
+		if (!stream.is_open())
+		{
+			fail("Failed to open input script: ", scriptName);
+			return false;
+		}
+
+		string line;
+		UInt32 lineNumber = 0;
+		while (getline(stream, line))
+		{
+			++lineNumber;
+			const size_t firstChar = line.find_first_not_of(" \t\r");
+			if (firstChar == string::npos || line[firstChar] == '#')
+			{
+				continue;
+			}
+
+			InputEvent event;
+			if (!parseInputEvent(line, event))
+			{
+				fail("Malformed input script line: ", lineNumber);
+				return false;
+			}
+			gInputEvents.push_back(event);
+		}
+
+		// Scripts don't have to be in order, but playback does.
+		stable_sort(gInputEvents.begin(), gInputEvents.end(), [](const InputEvent& a, const InputEvent& b)
+		{
+			return a.mPoll < b.mPoll;
+		});
+		return true;
+	}
+
+	void platformHeadlessSetMaxPolls(const UInt32 maxPolls)
+	{
+		gMaxPolls = maxPolls;
+	}
+
+	void platformHeadlessSetRandSeed(const UInt64 seed)
+	{
+		gRandSeed = seed;
+	}
+
+	UInt32 platformHeadlessGetFrameCount()
+	{
+		return gFrameCount;
+	}
+
+	UInt32 platformHeadlessGetPollCount()
+	{
+		return gPollCount;
+	}
+
+} // namespace SynchingFeeling
+
+#endif //#ifdef HEADLESS
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+
+// Please note that the headless platform implementation has no window, audio device or input device.
+// It runs uncapped, reads input from a script file and copies frames into a buffer owned by the caller.
+// It is intended for batch, throughput and regression runs on machines without display or sound hardware.
+
+#ifdef HEADLESS
+
+// Do nothing, static memory is fine as is
+#define FOR_STATIC_MEMORY
+
+#ifdef DEBUG
+#define ALLOW_LOG
+#endif
+
+#include <iostream>
+#include "Chip8Emu/EmuTypes.h"
+#include "Chip8Emu/UpdateClock.h"
+#include "Chip8Emu/Upscale.h"
+
+namespace SynchingFeeling
+{
+	// No change for headless
+	typedef Char StaticChar;
+	typedef UChar StaticUChar;
+	typedef Int16 StaticInt16;
+	typedef UInt16 StaticUInt16;
+	typedef Int32 StaticInt32;
+	typedef UInt32 StaticUInt32;
+
+	template<typename T>
+	void fail(T arg)
+	{
+#ifdef ALLOW_LOG
+		std::cerr << arg;
+#endif
+	}
+
+	template <typename... T>
+	void fail(const char* message, T... args)
+	{
+#ifdef ALLOW_LOG
+		std::cerr << message;
+		fail(args...);
+		std::cerr << std::endl;
+#endif
+	}
+
+	template<typename T>
+	void log(T arg)
+	{
+#ifdef ALLOW_LOG
+		std::cout << arg;
+#endif
+	}
+
+	template <typename... T>
+	void log(const char* message, T... args)
+	{
+#ifdef ALLOW_LOG
+		std::cout << message;
+		log(args...);
+		std::cout << std::endl;
+#endif
+	}
+
+	void platformInit(const Int32 pixelsWidth, const Int32 pixelsHeight, const Int32 screenWidth, const Int32 screenHeight);
+	void platformDeInit();
+	void platformRenderInit();
+	void platformRenderDeInit();
+	void platformSetColours(const UInt32 foreground, const UInt32 background);
+	void platformSetUpscale(const EUpscaleFilter::Type filter, const UInt32 nearestScale);
+	void platformSetPhosphor(const UInt32 decay);
+	bool platformIsFading();
+	void platformDraw(const UInt64* gfx, const Int32 width, const Int32 height, const UInt32 dirtyRows);
+	bool platformPollInput(UShort& inOutKeys, Char& inOutShouldUpdateCycleRate);
+	void platformPlaySound(const UInt64 timeNS);
+	void platformStopSound(const UInt64 timeNS);
+	bool platformCanUpdate(UInt32& inOutTicksIntoYield, const UInt32 yieldTimeMS);
+	UInt32 platformGetTicksUntilUpdate(const UInt32 ticksIntoYield, const UInt32 yieldTimeMS);
+	bool platformWaitForEvent(const UInt32 timeoutMS);
+	void platformPumpEvents(const UInt32 timeoutMS);
+	UInt32 platformTakeDueUpdates(UpdateClock& inOutClock, const UInt32 maxUpdates);
+	UInt64 platformGetNSUntilDue(const UpdateClock& clock);
+	UInt32 platformGetTicks();
+	UInt64 platformGetTimeNS();
+	void platformLoadGame(const char* gameName, char* readBuffer, const UInt32 readSize);
+	UInt64 platformGetRandSeed();
+
+	// Headless only.
+	// Every platformDraw expands the frame (one word per row) to one byte per pixel, 0x00 or 0xFF, in this buffer. The caller keeps ownership.
+	// Passing nullptr stops frame delivery.
+	void platformHeadlessSetFrameBuffer(UChar* frameBuffer, const UInt32 frameBufferSize);
+
+	// Loads an input script (or recorded movie), one event per line:
+	//   <poll> down <key>
+	//   <poll> up <key>
+	//   <poll> quit
+	// <poll> is the zero based platformPollInput call the event applies on, <key> is 0-F. Lines starting with # are ignored.
+	// Keys are held independently, any number can be down at once and up only releases the key given.
+	bool platformHeadlessLoadInputScript(const char* scriptName);
+
+	// Request a quit after this many polls, 0 runs until the script quits.
+	void platformHeadlessSetMaxPolls(const UInt32 maxPolls);
+
+	// What platformGetRandSeed gives machines for CXNN, so runs can be reproduced.
+	void platformHeadlessSetRandSeed(const UInt64 seed);
+
+	UInt32 platformHeadlessGetFrameCount();
+	UInt32 platformHeadlessGetPollCount();
+}
+
+#endif //#ifdef HEADLESS
\ No newline at end of file
@@ -4,12 +4,26 @@
 // https://www.libsdl.org/
 
 #include "Chip8Emu/PlatformWin.h"
+#include "Chip8Emu/Beeper.h"
+#include "Chip8Emu/Phosphor.h"
+#include "Chip8Emu/PixelExpand.h"
+#include "Chip8Emu/Upscale.h"
 
 #include <iostream>
 #include <fstream>
 #include <random>
+#include <string.h>
+#include <thread>
+#ifdef CHIP8_RENDER_THREAD
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#endif
 
 #include <SDL.h>
+#include <windows.h>
+#include <mmsystem.h>
 
 using namespace std;
 
@@ -17,29 +31,59 @@ namespace SynchingFeeling
 {
 	namespace
 	{
-		// SDL seems reluctant to let us use SDL_PIXELFORMAT_INDEX1LSB
-		// We'll use a 3 byte texture format instead: SDL_PIXELFORMAT_RGB24 as it takes uint8 array of data.
+		// SDL seems reluctant to let us use SDL_PIXELFORMAT_INDEX1LSB (or any indexed format) for textures.
+		// Pixels are written straight into a streaming texture in the renderers' native 4 byte format.
+		static const UInt32 kStreamingPixelFormatEnum = SDL_PIXELFORMAT_ARGB8888;
+
+		// System timer resolution while the platform runs, and the step platformWaitForEvent sleeps in.
+		static const UInt32 kTimerResolutionMS = 1;
+
+		// Where streaming textures aren't available we'll use a 3 byte texture format instead: SDL_PIXELFORMAT_RGB24 as it takes uint8 array of data.
+		// It's filled from a staging buffer.
 		static const UInt32 kPixelFormatEnum = SDL_PIXELFORMAT_RGB24;
 
-		// Minimum 'good' audio lower bound, from SDL2.0 docs says 512 (0x200)
-		// Buuut that's at odds with the audio sample time and we have if adhering to the SDL freqency formula (only dogs will hear)
-		// This seems to work pretty well actually, even though its much lower than the recommended size.
-		static const UInt16 kAudioSamplesSize = 0x10;
-		// Seems to need to be less than the minimum timer length ((1/60))
-		// Any longer and some of the more subtle sounds are inaudiable
-		static const Int32 kAudioSampleTimeInMs = 10; 		
-		static const UChar kAudioSampleAmplitude = 0x10;
+		// Asked for, the device's own rate is used if it differs.
+		// Beeps are placed by timestamp rather than by buffer, so the recommended 512 (0x200) samples no longer costs any timing.
+		static const Int32 kAudioFrequency = 48000;
+		static const UInt16 kAudioSamplesSize = 0x200;
+
+		// Dirty row mask covering the whole texture.
+		static const UInt32 kAllRows = 0xFFFFFFFF;
+
+		// Most threads upscaling splits over, the render thread included.
+		static const UInt32 kMaxUpscaleThreads = 4;
 
 		static SDL_Window* gWindow;
 		static SDL_Renderer* gRenderer;
 		static SDL_Texture* gTexture;
 		static UChar* gRenderTexture;
+		static Int32 gPixelsWidth;
+		static Int32 gPixelsHeight;
 		static UInt32 gRenderTextureSize;
+		static bool gTextureStale;
+		static bool gTextureStreaming;
+		static PixelColours gColours;
+		static EUpscaleFilter::Type gUpscaleFilter = EUpscaleFilter::Nearest;
+		static UInt32 gUpscaleNearestScale = 1;
+		static Upscaler gUpscaler;
+		static UInt32 gPhosphorDecay;
+		static Phosphor gPhosphor;
 		static enum gPixelFormatEnum;
 		static SDL_PixelFormat* gPixelFormat;
-		static SDL_AudioSpec* gObtainedAudioSpec;
-		static SDL_AudioStatus gAudioStatus;
-		static mt19937 gRandGen;
+		static SDL_AudioDeviceID gAudioDevice;
+		static Beeper gBeeper;
+		static UInt64 gRandSeed;
+		static bool gTimerPeriodRaised;								// timeBeginPeriod succeeded, so platformDeInit ends it
+
+#ifdef CHIP8_RENDER_THREAD
+		// Emulation runs on a thread of its own, the window thread takes SDL's events in platformPumpEvents and hands input over through these.
+		static atomic<UShort> gInputKeys;							// Keys held down, bit N for key N
+		static atomic<Char> gInputCycleRate;						// The last +/- press not yet polled, 0 for none
+		static atomic<bool> gInputQuit;
+		static mutex gInputMutex;									// Guards gInputArrived, so platformWaitForEvent can't miss a wake
+		static condition_variable gInputWake;
+		static bool gInputArrived;
+#endif
 
 
 		// Key mappings
@@ -68,6 +112,183 @@ namespace SynchingFeeling
 			SDLK_v  // F
 		};
 		static const Int32 kKeyMappingsSize = (sizeof(kKeyMappings) / sizeof(Int32));
+
+		// Keycode to key, built from kKeyMappings. The mapped keys are all ASCII, so their keycodes index it directly.
+		static const Int32 kKeyLookupSize = 128;
+		static UChar gKeyLookup[kKeyLookupSize];
+
+		void buildKeyLookup()
+		{
+			memset(gKeyLookup, kInvalidKey, sizeof(gKeyLookup));
+			for (UChar i = 0; i < kKeyMappingsSize; ++i)
+			{
+				gKeyLookup[kKeyMappings[i]] = i;
+			}
+		}
+
+		// kInvalidKey for keycodes that aren't mapped.
+		UChar findKey(const SDL_Keycode keycode)
+		{
+			return (keycode >= 0 && keycode < kKeyLookupSize) ? gKeyLookup[keycode] : kInvalidKey;
+		}
+
+		// Converts rows [firstRow, endRow) into pixels laid out as the texture, pixels being where firstRow starts.
+		void convertRows(const UInt64* gfx, const Int32 width, const Int32 height, const Int32 firstRow, const Int32 endRow, UChar* pixels, const Int32 pitch)
+		{
+			if (!gTextureStreaming)
+			{
+				for (Int32 y = firstRow; y < endRow; ++y)
+				{
+					expandRowRGB24(gfx[y], width, gColours, pixels + ((y - firstRow) * pitch));
+				}
+			}
+			else if (gPhosphor.isEnabled())
+			{
+				gPhosphor.writeRowsRGBA32(width, firstRow, endRow, gUpscaler.getScale(), pixels, pitch);
+			}
+			else
+			{
+				gUpscaler.upscale(gfx, width, height, firstRow, endRow, gColours, pixels, pitch);
+			}
+		}
+
+		// The part of the texture rows [firstRow, endRow) cover.
+		SDL_Rect getRowsRect(const Int32 firstRow, const Int32 endRow)
+		{
+			const Int32 scale = (gTextureStreaming) ? static_cast<Int32>(gUpscaler.getScale()) : 1;
+			const SDL_Rect rect = { 0, firstRow * scale, gPixelsWidth * scale, (endRow - firstRow) * scale };
+			return rect;
+		}
+
+		// Calls rowsRun(firstRow, endRow) for each run of neighbouring rows set in rows, stopping early if it returns false.
+		template<typename RowsRun>
+		bool forEachRowsRun(const UInt32 rows, const Int32 height, RowsRun rowsRun)
+		{
+			Int32 y = 0;
+			while (y < height)
+			{
+				if (((rows >> y) & 1) == 0)
+				{
+					++y;
+					continue;
+				}
+
+				const Int32 firstRow = y;
+				while (y < height && ((rows >> y) & 1) != 0)
+				{
+					++y;
+				}
+
+				if (!rowsRun(firstRow, y))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Converts rows [firstRow, endRow) straight into the streaming texture, or through the staging buffer into the static one.
+		bool uploadRows(const UInt64* gfx, const Int32 width, const Int32 height, const Int32 firstRow, const Int32 endRow)
+		{
+			const SDL_Rect rect = getRowsRect(firstRow, endRow);
+			if (!gTextureStreaming)
+			{
+				const Int32 pitch = width * gPixelFormat->BytesPerPixel;
+				UChar* staged = gRenderTexture + (firstRow * pitch);
+				convertRows(gfx, width, height, firstRow, endRow, staged, pitch);
+				if (0 != SDL_UpdateTexture(gTexture, &rect, reinterpret_cast<const void*>(staged), pitch))
+				{
+					fail("SDL_UpdateTexture failed! SDL_Error: ", SDL_GetError());
+					return false;
+				}
+				return true;
+			}
+
+			// Locked texture memory is write only, every pixel in the rect gets written.
+			void* pixels = nullptr;
+			int pitch = 0;
+			if (0 != SDL_LockTexture(gTexture, &rect, &pixels, &pitch))
+			{
+				fail("SDL_LockTexture failed! SDL_Error: ", SDL_GetError());
+				return false;
+			}
+			convertRows(gfx, width, height, firstRow, endRow, static_cast<UChar*>(pixels), pitch);
+			SDL_UnlockTexture(gTexture);
+			return true;
+		}
+
+		void presentTexture()
+		{
+			if(0 != SDL_RenderClear(gRenderer))
+			{
+				fail("SDL_RenderClear failed! SDL_Error: ", SDL_GetError());
+				return;
+			}
+
+			if (0 != SDL_RenderCopy(gRenderer, gTexture, nullptr, nullptr))
+			{
+				fail("SDL_RenderCopy failed! SDL_Error: ", SDL_GetError());
+				return;
+			}
+
+			// No return
+			SDL_RenderPresent(gRenderer);
+		}
+
+		// Applies an SDL event to the input, keys held, a +/- press and quit.
+		void handleEvent(const SDL_Event& e, UShort& inOutKeys, Char& inOutShouldUpdateCycleRate, bool& inOutShouldQuit)
+		{
+			switch (e.type)
+			{
+				case SDL_QUIT:
+					inOutShouldQuit = true;
+					break;
+
+				case SDL_KEYDOWN:
+				{
+					const UChar key = findKey(e.key.keysym.sym);
+					if (key != kInvalidKey)
+					{
+						inOutKeys |= static_cast<UShort>(1 << key);
+					}
+
+					switch (e.key.keysym.sym)
+					{
+						// increment cycle rate
+						case SDLK_PLUS:
+						case SDLK_EQUALS:
+							inOutShouldUpdateCycleRate = 1;
+							break;
+
+						// decrement cycle rate
+						case SDLK_MINUS:
+						case SDLK_UNDERSCORE:
+							inOutShouldUpdateCycleRate = -1;
+							break;
+					}
+					break;
+				}
+
+				case SDL_KEYUP:
+				{
+					// Only this key is released, any others stay down.
+					const UChar key = findKey(e.key.keysym.sym);
+					if (key != kInvalidKey)
+					{
+						inOutKeys &= static_cast<UShort>(~(1 << key));
+					}
+					break;
+				}
+
+				case SDL_WINDOWEVENT:
+					// Key ups don't arrive once focus has gone, so nothing is left held down.
+					if (e.window.event == SDL_WINDOWEVENT_FOCUS_LOST)
+					{
+						inOutKeys = 0;
+					}
+					break;
+			}
+		}
 	
 	} // namespace
 
@@ -116,209 +337,292 @@ namespace SynchingFeeling
 			return;
 		}
 
-		gRenderer = SDL_CreateRenderer(gWindow, -1, 0);
-		if (!gRenderer)
-		{
-			fail("Renderer could not be created! SDL_Error: ", SDL_GetError());
-			return;
-		}
+		gPixelsWidth = pixelsWidth;
+		gPixelsHeight = pixelsHeight;
 
-		
-		gTexture = SDL_CreateTexture(gRenderer, kPixelFormatEnum, SDL_TEXTUREACCESS_STATIC, pixelsWidth, pixelsHeight);
-		if (!gTexture)
-		{
-			fail("Texture could not be created! SDL_Error: ", SDL_GetError());
-		}
+		// Sleeps otherwise round up to the default 15.6ms tick.
+		gTimerPeriodRaised = (timeBeginPeriod(kTimerResolutionMS) == TIMERR_NOERROR);
+		buildKeyLookup();
 
-		gPixelFormat = SDL_AllocFormat(kPixelFormatEnum);
-		if (!gPixelFormat)
-		{
-			gRenderTexture = nullptr;
-			fail("Could not create pixel format from enum! SDL_Error: ", SDL_GetError());
-		}
-		else
-		{
-			gRenderTextureSize = pixelsWidth * pixelsHeight * gPixelFormat->BytesPerPixel;
-			gRenderTexture = new UChar[gRenderTextureSize];
-		}
+#ifdef CHIP8_RENDER_THREAD
+		gInputKeys.store(0, memory_order_relaxed);
+		gInputCycleRate.store(0, memory_order_relaxed);
+		gInputQuit.store(false, memory_order_relaxed);
+		gInputArrived = false;
+#endif
 
-		// Populate a memory buffer with a waveform.
-		// This goes wide so let's just create the waveform inline.
+		// The device runs for as long as the platform does, the callback renders the beeper from the sound events emulation has queued, without locking.
 		SDL_AudioSpec desiredAudioSpec;
+		memset(&desiredAudioSpec, 0, sizeof(desiredAudioSpec));
 		desiredAudioSpec.callback = [](void*, Uint8* buffer, int bufferSize)
 		{
-			SDL_LockAudio();
-			
-			Char sign = 1;
-			for (auto i = 0; i < bufferSize; ++i)
-			{
-				UChar squareWave = (0x80 + (sign * kAudioSampleAmplitude));
-				buffer[i] = squareWave;
-				sign = -sign;
-			}
-			
-			SDL_UnlockAudio();
+			gBeeper.render(reinterpret_cast<Int16*>(buffer), static_cast<UInt32>(bufferSize) / sizeof(Int16), platformGetTimeNS());
 		};
 
 		// mono
 		desiredAudioSpec.channels = 1;
-		desiredAudioSpec.format = AUDIO_U8;
-		desiredAudioSpec.padding = 0;
+		desiredAudioSpec.format = AUDIO_S16SYS;
 		desiredAudioSpec.userdata = nullptr;
 
-		// freq = (samples * 1000) / ms
 		desiredAudioSpec.samples = kAudioSamplesSize;
-		desiredAudioSpec.freq = (kAudioSamplesSize * 1000) / kAudioSampleTimeInMs;
+		desiredAudioSpec.freq = kAudioFrequency;
 
-		if(0 != SDL_OpenAudio(&desiredAudioSpec, gObtainedAudioSpec))
+		SDL_AudioSpec obtainedAudioSpec;
+		gAudioDevice = SDL_OpenAudioDevice(nullptr, 0, &desiredAudioSpec, &obtainedAudioSpec, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+		if (gAudioDevice == 0)
 		{
 			fail("Could not initialise audio! SDL_Error: ", SDL_GetError());
 		}
+		else
+		{
+			gBeeper.configure(obtainedAudioSpec.freq, obtainedAudioSpec.samples);
+			SDL_PauseAudioDevice(gAudioDevice, 0);
+		}
 
-		// Seed rand
-		const auto seed = random_device()();
-		gRandGen.seed(seed);
+		// A different game every run.
+		random_device randomDevice;
+		gRandSeed = (static_cast<UInt64>(randomDevice()) << 32) | randomDevice();
 	}
 
 	void platformDeInit()
 	{
-		SDL_CloseAudio();
+		if (gAudioDevice != 0)
+		{
+			SDL_CloseAudioDevice(gAudioDevice);
+			gAudioDevice = 0;
+		}
+
+		SDL_DestroyWindow(gWindow);
+		gWindow = nullptr;
+
+		SDL_Quit();
+
+		// platformInit may have failed before it got this far.
+		if (gTimerPeriodRaised)
+		{
+			timeEndPeriod(kTimerResolutionMS);
+			gTimerPeriodRaised = false;
+		}
+	}
+
+	void platformRenderInit()
+	{
+		if (!gWindow)
+		{
+			fail("platformRenderInit failed, there is no window.");
+			return;
+		}
+
+		gRenderer = SDL_CreateRenderer(gWindow, -1, 0);
+		if (!gRenderer)
+		{
+			fail("Renderer could not be created! SDL_Error: ", SDL_GetError());
+			return;
+		}
+
+		// Bigger outputs are split over more threads, upscaling belongs to whichever thread renders.
+		const UInt32 scale = getUpscaleScale(gUpscaleFilter, gUpscaleNearestScale);
+		const UInt32 hardwareThreads = thread::hardware_concurrency();
+		const UInt32 upscaleThreads = (scale <= 2 || hardwareThreads < 2) ? 1 : ((hardwareThreads < kMaxUpscaleThreads) ? hardwareThreads : kMaxUpscaleThreads);
+		gUpscaler.configure(gUpscaleFilter, gUpscaleNearestScale, upscaleThreads - 1);
+
+		// Phosphor writes blended colours itself, nearest at the same scale, the upscaler just keeps the scale.
+		gPhosphor.configure(gPhosphorDecay);
+		if (gPhosphor.isEnabled())
+		{
+			gUpscaler.configure(EUpscaleFilter::Nearest, scale, 0);
+		}
+
+		gTexture = SDL_CreateTexture(gRenderer, kStreamingPixelFormatEnum, SDL_TEXTUREACCESS_STREAMING, gPixelsWidth * scale, gPixelsHeight * scale);
+		gTextureStreaming = (gTexture != nullptr);
+		if (!gTextureStreaming)
+		{
+			// No upscaling or phosphor either, SDL_RenderCopy scales on its own.
+			log("Streaming texture could not be created, falling back to a static texture. SDL_Error: ", SDL_GetError());
+			gUpscaler.configure(EUpscaleFilter::Nearest, 1, 0);
+			gPhosphor.configure(0);
+			gTexture = SDL_CreateTexture(gRenderer, kPixelFormatEnum, SDL_TEXTUREACCESS_STATIC, gPixelsWidth, gPixelsHeight);
+			if (!gTexture)
+			{
+				fail("Texture could not be created! SDL_Error: ", SDL_GetError());
+			}
 
+			gPixelFormat = SDL_AllocFormat(kPixelFormatEnum);
+			if (!gPixelFormat)
+			{
+				gRenderTexture = nullptr;
+				fail("Could not create pixel format from enum! SDL_Error: ", SDL_GetError());
+			}
+			else
+			{
+				gRenderTextureSize = gPixelsWidth * gPixelsHeight * gPixelFormat->BytesPerPixel;
+				gRenderTexture = new UChar[gRenderTextureSize];
+			}
+		}
+
+		// Nothing has been uploaded yet, the first draw sends every row.
+		gTextureStale = true;
+	}
+
+	void platformRenderDeInit()
+	{
 		delete[] gRenderTexture;
 		gRenderTexture = nullptr;
 
-		SDL_FreeFormat(gPixelFormat);
-		gPixelFormat = nullptr;
+		if (gPixelFormat)
+		{
+			SDL_FreeFormat(gPixelFormat);
+			gPixelFormat = nullptr;
+		}
 		
 		SDL_DestroyTexture(gTexture);
 		gTexture = nullptr;
 
 		SDL_DestroyRenderer(gRenderer);
-		gTexture = nullptr;
+		gRenderer = nullptr;
 
-		SDL_DestroyWindow(gWindow);
-		gWindow = nullptr;
+		gUpscaler.configure(EUpscaleFilter::Nearest, 1, 0);
+		gPhosphor.configure(0);
+	}
 
-		SDL_Quit();
+	void platformSetColours(const UInt32 foreground, const UInt32 background)
+	{
+		setPixelColours(gColours, foreground, background);
+		gPhosphor.setColours(foreground, background);
+
+		// Everything on screen is in the old colours.
+		gTextureStale = true;
 	}
 
-	void platformDraw(const void* gfx, const Int32 width, const Int32 height)
+	void platformSetUpscale(const EUpscaleFilter::Type filter, const UInt32 nearestScale)
 	{
-		if (!gWindow || !gRenderer || !gTexture || !gRenderTexture)
+		// Takes effect from the next platformRenderInit.
+		gUpscaleFilter = filter;
+		gUpscaleNearestScale = nearestScale;
+	}
+
+	void platformSetPhosphor(const UInt32 decay)
+	{
+		// Takes effect from the next platformRenderInit.
+		gPhosphorDecay = decay;
+	}
+
+	bool platformIsFading()
+	{
+		return gPhosphor.isFading();
+	}
+
+	void platformDraw(const UInt64* gfx, const Int32 width, const Int32 height, const UInt32 dirtyRows)
+	{
+		if (!gWindow || !gRenderer || !gTexture || (!gTextureStreaming && !gRenderTexture))
 		{
 			fail("platformDraw failed due to setup errors.");
 			return;
 		}
 
-		for (auto i = 0; i < width * height; ++i)
+		// Only rows changed since the last present are converted and uploaded, a run of neighbouring rows at a time.
+		// With phosphor on that's the rows whose intensities moved, fading rows included.
+		UInt32 rowsToUpload = (gTextureStale) ? kAllRows : gUpscaler.getAffectedRows(dirtyRows);
+		if (gPhosphor.isEnabled())
 		{
-			const auto currentByte = reinterpret_cast<const UChar*>(gfx)[i];
-			gRenderTexture[(i * gPixelFormat->BytesPerPixel)] = currentByte;
-			gRenderTexture[((i * gPixelFormat->BytesPerPixel) + 1)] = currentByte;
-			gRenderTexture[((i * gPixelFormat->BytesPerPixel) + 2)] = currentByte;
+			rowsToUpload = gPhosphor.update(gfx, width, height, dirtyRows) | ((gTextureStale) ? kAllRows : 0);
 		}
+		gTextureStale = false;
 
-		if (0 != SDL_UpdateTexture(gTexture, nullptr, reinterpret_cast<const void*>(gRenderTexture), width * gPixelFormat->BytesPerPixel))
+		if (rowsToUpload == 0)
 		{
-			fail("SDL_UpdateTexture failed! SDL_Error: ", SDL_GetError());
 			return;
 		}
 
-		if(0 != SDL_RenderClear(gRenderer))
+		const bool uploaded = forEachRowsRun(rowsToUpload, height, [&](const Int32 firstRow, const Int32 endRow)
 		{
-			fail("SDL_RenderClear failed! SDL_Error: ", SDL_GetError());
-			return;
-		}
-
-		if (0 != SDL_RenderCopy(gRenderer, gTexture, nullptr, nullptr))
+			return uploadRows(gfx, width, height, firstRow, endRow);
+		});
+		if (uploaded)
 		{
-			fail("SDL_RenderCopy failed! SDL_Error: ", SDL_GetError());
-			return;
+			presentTexture();
 		}
-
-		// No return
-		SDL_RenderPresent(gRenderer);
 	}
 
-	bool platformPollInput(UChar& inOutKeyPressed, Char& inOutShouldUpdateCycleRate)
+	bool platformPollInput(UShort& inOutKeys, Char& inOutShouldUpdateCycleRate)
 	{
-		// poll for new
+#ifdef CHIP8_RENDER_THREAD
+		// On the emulation thread, platformPumpEvents has already taken the window's events.
+		inOutKeys = gInputKeys.load(memory_order_acquire);
+		const Char cycleRate = gInputCycleRate.exchange(0, memory_order_acq_rel);
+		if (cycleRate != 0)
+		{
+			inOutShouldUpdateCycleRate = cycleRate;
+		}
+		return gInputQuit.load(memory_order_acquire);
+#else
+		// Drain everything queued since the last poll, so no key change waits a pass behind another.
 		SDL_Event e;
 		bool shouldQuit = false;
-		const auto eventResult = SDL_PollEvent(&e);
-		if (eventResult == 0)
-		{ 
-			return false;
+		while (SDL_PollEvent(&e) != 0)
+		{
+			handleEvent(e, inOutKeys, inOutShouldUpdateCycleRate, shouldQuit);
 		}
+		return shouldQuit;
+#endif
+	}
 
-		switch (e.type)
+#ifdef CHIP8_RENDER_THREAD
+	void platformPumpEvents(const UInt32 timeoutMS)
+	{
+		// On the window thread, SDL only takes events there. Input is handed over to emulation's platformPollInput as it arrives.
+		// A millisecond at a time, SDL 2.0.3's SDL_WaitEventTimeout only checks every 10ms.
+		const UInt32 startTicks = SDL_GetTicks();
+		for (;;)
 		{
-			case SDL_QUIT:
-				shouldQuit = true;
-				break;
+			UShort keys = gInputKeys.load(memory_order_relaxed);
+			Char cycleRate = 0;
+			bool shouldQuit = false;
+			bool anyInput = false;
+			SDL_Event e;
+			while (SDL_PollEvent(&e) != 0)
+			{
+				handleEvent(e, keys, cycleRate, shouldQuit);
+				anyInput = anyInput || (e.type == SDL_QUIT) || (e.type == SDL_KEYDOWN) || (e.type == SDL_KEYUP) || (e.type == SDL_WINDOWEVENT);
+			}
 
-			case SDL_KEYDOWN:
-				for (UChar i = 0; i < kKeyMappingsSize; ++i)
+			if (anyInput)
+			{
+				gInputKeys.store(keys, memory_order_release);
+				if (cycleRate != 0)
 				{
-					if (kKeyMappings[i] == e.key.keysym.sym)
-					{
-						inOutKeyPressed = i;
-						break;
-					}
+					gInputCycleRate.store(cycleRate, memory_order_release);
 				}
-
-				switch (e.key.keysym.sym)
+				if (shouldQuit)
 				{
-					// increment cycle rate
-					case SDLK_PLUS:
-					case SDLK_EQUALS:
-						inOutShouldUpdateCycleRate = 1;
-						break;
-
-					// decrement cycle rate
-					case SDLK_MINUS:
-					case SDLK_UNDERSCORE:
-						inOutShouldUpdateCycleRate = -1;
-						break;
+					gInputQuit.store(true, memory_order_release);
 				}
-				break;
 
-			case SDL_KEYUP:
-			{
-				for (UChar i = 0; i < kKeyMappingsSize; ++i)
+				// Wakes emulation should it be waiting in platformWaitForEvent.
 				{
-					if (kKeyMappings[i] == e.key.keysym.sym)
-					{
-						inOutKeyPressed = kInvalidKey;
-						break;
-					}
+					lock_guard<mutex> lock(gInputMutex);
+					gInputArrived = true;
 				}
-				break;
+				gInputWake.notify_one();
 			}
 
+			if ((SDL_GetTicks() - startTicks) >= timeoutMS)
+			{
+				return;
+			}
+			SDL_Delay(kTimerResolutionMS);
 		}
-		return shouldQuit;
 	}
+#endif
 
-	void platformUpdateAudio()
+	void platformPlaySound(const UInt64 timeNS)
 	{
-		gAudioStatus = SDL_GetAudioStatus();
+		gBeeper.push(timeNS, true);
 	}
 
-	void platformPlaySound()
+	void platformStopSound(const UInt64 timeNS)
 	{
-		if (gAudioStatus != SDL_AUDIO_PLAYING)
-		{
-			SDL_PauseAudio(0);
-		}
-	}
-
-	void platformStopSound()
-	{
-		if (gAudioStatus == SDL_AUDIO_PLAYING)
-		{
-			SDL_PauseAudio(1);
-		}
+		gBeeper.push(timeNS, false);
 	}
 
 	bool platformCanUpdate(UInt32& inOutTicksIntoYield, const UInt32 yieldTimeMS)
@@ -340,6 +644,69 @@ namespace SynchingFeeling
 		return false;
 	}
 
+	UInt32 platformGetTicksUntilUpdate(const UInt32 ticksIntoYield, const UInt32 yieldTimeMS)
+	{
+		// Not started yet, the first platformCanUpdate starts it.
+		if (ticksIntoYield == 0)
+		{
+			return 0;
+		}
+
+		const UInt32 elapsed = SDL_GetTicks() - ticksIntoYield;
+		return (elapsed >= yieldTimeMS) ? 0 : (yieldTimeMS - elapsed);
+	}
+
+	bool platformWaitForEvent(const UInt32 timeoutMS)
+	{
+#ifdef CHIP8_RENDER_THREAD
+		// On the emulation thread, woken by platformPumpEvents. Timed waits are as precise as the 1ms system timer.
+		unique_lock<mutex> lock(gInputMutex);
+		const bool arrived = gInputWake.wait_for(lock, chrono::milliseconds(timeoutMS), [] { return gInputArrived; });
+		gInputArrived = false;
+		return arrived;
+#else
+		// SDL 2.0.3's SDL_WaitEventTimeout only checks for events every 10ms, overshooting the ~2ms deadlines of the original loop and holding input back.
+		// Sleeping a millisecond at a time and pumping in between keeps both to about a millisecond. Leaves events queued for platformPollInput.
+		const UInt32 startTicks = SDL_GetTicks();
+		for (;;)
+		{
+			SDL_PumpEvents();
+			if (SDL_HasEvents(SDL_FIRSTEVENT, SDL_LASTEVENT))
+			{
+				return true;
+			}
+			if ((SDL_GetTicks() - startTicks) >= timeoutMS)
+			{
+				return false;
+			}
+			SDL_Delay(kTimerResolutionMS);
+		}
+#endif
+	}
+
+	UInt32 platformTakeDueUpdates(UpdateClock& inOutClock, const UInt32 maxUpdates)
+	{
+		return takeDueUpdates(inOutClock, platformGetTimeNS(), maxUpdates);
+	}
+
+	UInt64 platformGetNSUntilDue(const UpdateClock& clock)
+	{
+		return getNSUntilDue(clock, platformGetTimeNS());
+	}
+
+	UInt32 platformGetTicks()
+	{
+		return SDL_GetTicks();
+	}
+
+	UInt64 platformGetTimeNS()
+	{
+		// Split so the multiply can't overflow on a counter that's been running a while.
+		const UInt64 counter = SDL_GetPerformanceCounter();
+		const UInt64 frequency = SDL_GetPerformanceFrequency();
+		return ((counter / frequency) * kNSPerSecond) + (((counter % frequency) * kNSPerSecond) / frequency);
+	}
+
 	void platformLoadGame(const char* gameName, char* readBuffer, const UInt32 readSize)
 	{
 		ifstream stream;
@@ -355,10 +722,9 @@ namespace SynchingFeeling
 		stream.close();
 	}
 
-	UChar platformRand(const UChar mask)
+	UInt64 platformGetRandSeed()
 	{
-		uniform_int_distribution<> dist(0, mask);
-		return static_cast<UChar>(dist(gRandGen));
+		return gRandSeed;
 	}
 
 
@@ -0,0 +1,148 @@
+#ifdef CHIP8_RENDER_THREAD
+
+#include "Presenter.h"
+
+#include <string.h>
+
+#if defined HEADLESS
+#include "PlatformHeadless.h"
+#elif defined WIN32
+#include "PlatformWin.h"
+#endif
+
+using namespace std;
+
+namespace SynchingFeeling
+{
+	namespace
+	{
+		// How long the window thread takes events for when there's nothing to present.
+		static const UInt32 kIdleMS = 1;
+
+	} // namespace
+
+	FrameExchange::FrameExchange()
+		: mBack(0)
+		, mFront(1)
+		, mMiddle(2)
+	{
+		memset(mFrames, 0, sizeof(mFrames));
+	}
+
+	bool FrameExchange::publish()
+	{
+		// Release the finished back frame to the reader, and take back whichever frame was waiting in the middle.
+		const UInt32 previous = mMiddle.exchange(mBack | kFreshBit, memory_order_acq_rel);
+		mBack = previous & ~kFreshBit;
+		return (previous & kFreshBit) != 0;
+	}
+
+	bool FrameExchange::acquire()
+	{
+		if ((mMiddle.load(memory_order_relaxed) & kFreshBit) == 0)
+		{
+			return false;
+		}
+
+		// Only the writer sets kFreshBit, so it's still there to take.
+		const UInt32 previous = mMiddle.exchange(mFront, memory_order_acq_rel);
+		mFront = previous & ~kFreshBit;
+		return true;
+	}
+
+	Presenter::Presenter()
+		: mQuit(false)
+		, mShownValid(false)
+		, mPresentTicksSinceLastUpdate(0)
+	{
+		memset(mShown, 0, sizeof(mShown));
+		memset(&mStats, 0, sizeof(mStats));
+	}
+
+	bool Presenter::publish(const Chip8Machine& machine)
+	{
+		Frame& frame = mExchange.getBackFrame();
+		memcpy(frame.mGfx, machine.getGfx(), sizeof(frame.mGfx));
+		frame.mPublishedTicks = platformGetTicks();
+		return mExchange.publish();
+	}
+
+	void Presenter::finish()
+	{
+		mQuit.store(true, memory_order_release);
+	}
+
+	void Presenter::addStats(EmuStats& outStats) const
+	{
+		outStats.mDraws += mStats.mDraws;
+		outStats.mPresentLatencyTotalMS += mStats.mPresentLatencyTotalMS;
+		if (mStats.mPresentLatencyMaxMS > outStats.mPresentLatencyMaxMS)
+		{
+			outStats.mPresentLatencyMaxMS = mStats.mPresentLatencyMaxMS;
+		}
+	}
+
+	void Presenter::run()
+	{
+		while (!mQuit.load(memory_order_acquire))
+		{
+			if (!platformCanUpdate(mPresentTicksSinceLastUpdate, kPresentRateMS))
+			{
+				// Takes window events through to the next present slot.
+				const UInt32 ticksUntilDue = platformGetTicksUntilUpdate(mPresentTicksSinceLastUpdate, kPresentRateMS);
+				platformPumpEvents((ticksUntilDue != 0) ? ticksUntilDue : kIdleMS);
+				continue;
+			}
+			presentNewest();
+		}
+
+		// The last frame published is always shown.
+		presentNewest();
+	}
+
+	void Presenter::presentNewest()
+	{
+		// A fading display still needs presenting when no new frame came in, the last one is shown again.
+		if (!mExchange.acquire() && !platformIsFading())
+		{
+			platformPumpEvents(kIdleMS);
+			return;
+		}
+
+		// Rows are compared against the last present, rather than carried over, so frames dropped in between don't lose theirs.
+		const Frame& frame = mExchange.getFrontFrame();
+		UInt32 dirtyRows = (mShownValid) ? 0 : kGFXAllRows;
+		for (Int32 y = 0; y < kGFXHeight; ++y)
+		{
+			if (frame.mGfx[y] != mShown[y])
+			{
+				dirtyRows |= 1u << y;
+				mShown[y] = frame.mGfx[y];
+			}
+		}
+
+		if (dirtyRows == 0 && !platformIsFading())
+		{
+			return;
+		}
+		mShownValid = true;
+
+		++mStats.mDraws;
+		platformDraw(frame.mGfx, kGFXWidth, kGFXHeight, dirtyRows);
+		if (dirtyRows == 0)
+		{
+			// Nothing new, so no latency to measure.
+			return;
+		}
+
+		const UInt32 latency = platformGetTicks() - frame.mPublishedTicks;
+		mStats.mPresentLatencyTotalMS += latency;
+		if (latency > mStats.mPresentLatencyMaxMS)
+		{
+			mStats.mPresentLatencyMaxMS = latency;
+		}
+	}
+
+} // namespace SynchingFeeling
+
+#endif //#ifdef CHIP8_RENDER_THREAD
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+
+#include "Emu.h"
+#include "EmuTypes.h"
+#include "Machine.h"
+
+namespace SynchingFeeling
+{
+	// A finished frame on its way from emulation to the screen.
+	struct Frame
+	{
+		UInt64 mGfx[kGFXHeight];									// One word per row, as Chip8State::mGfx
+		UInt32 mPublishedTicks;										// platformGetTicks when it was handed over
+	};
+
+	// Lock free triple buffer between one writer and one reader thread.
+	// The writer always has a frame of its own to fill and the reader one to show, the third holds the newest finished frame.
+	// Neither side ever waits on the other.
+	class FrameExchange
+	{
+	public:
+		FrameExchange();
+
+		// Writer only. The frame to fill before publishing, its previous contents are stale.
+		Frame& getBackFrame() { return mFrames[mBack]; }
+
+		// Writer only. Makes the back frame the newest, true if the one it replaces was never acquired.
+		bool publish();
+
+		// Reader only. Takes the newest frame, false if nothing was published since the last acquire.
+		bool acquire();
+
+		// Reader only. The last frame acquired.
+		const Frame& getFrontFrame() const { return mFrames[mFront]; }
+
+	private:
+		static const UInt32 kFreshBit = 0x4;						// Set in mMiddle while it holds a frame not yet acquired
+
+		Frame mFrames[3];
+		UInt32 mBack;												// Writer's frame
+		UInt32 mFront;												// Reader's frame
+		std::atomic<UInt32> mMiddle;								// Newest published frame, plus kFreshBit
+	};
+
+	// Presents frames on the thread that owns the window, while emulation runs on a thread of its own, so a slow present never holds up emulation.
+	// It's the thread SDL needs rendering and window events on, platformPumpEvents hands the input over.
+	// Presents at most once per display refresh, always the newest frame, and only the rows that changed since the last present.
+	class Presenter
+	{
+	public:
+		Presenter();
+
+		// Window thread. Presents and pumps events until finish is called, then presents the newest frame if it hasn't been already.
+		// The platform and its renderer must already be initialised.
+		void run();
+
+		// Emulation thread. Hands over the machine's current frame, true if it replaced one that was never presented.
+		bool publish(const Chip8Machine& machine);
+
+		// Emulation thread, once it has published its last frame. run returns soon after.
+		void finish();
+
+		// Once run has returned. Render side stats (draws and latency) are added to outStats.
+		void addStats(EmuStats& outStats) const;
+
+	private:
+		Presenter(const Presenter&);
+		Presenter& operator=(const Presenter&);
+
+		void presentNewest();
+
+		FrameExchange mExchange;
+		std::atomic<bool> mQuit;
+
+		// Window thread only, read once run has returned.
+		UInt64 mShown[kGFXHeight];									// What the platform was last given
+		bool mShownValid;											// False until the first present
+		UInt32 mPresentTicksSinceLastUpdate;						// The timer for presenting frames
+		EmuStats mStats;
+	};
+}
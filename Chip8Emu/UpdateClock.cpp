@@ -0,0 +1,73 @@
+#include "UpdateClock.h"
+
+namespace SynchingFeeling
+{
+	namespace
+	{
+		// Owed time, capped so a long stall can't overflow the credit or be raced through afterwards.
+		inline UInt64 getCredit(const UpdateClock& clock, const UInt64 nowNS)
+		{
+			const UInt64 elapsedNS = nowNS - clock.mLastNS;
+			const UInt64 maxCredit = kUpdateClockMaxCatchUpNS * clock.mPerSecond;
+			const UInt64 credit = clock.mCredit + (((elapsedNS < kUpdateClockMaxCatchUpNS) ? elapsedNS : kUpdateClockMaxCatchUpNS) * clock.mPerSecond);
+			return (credit < maxCredit) ? credit : maxCredit;
+		}
+
+	} // namespace
+
+	void startUpdateClock(UpdateClock& outClock, const UInt32 perSecond)
+	{
+		outClock.mLastNS = 0;
+		outClock.mCredit = 0;
+		outClock.mPerSecond = perSecond;
+		outClock.mStarted = false;
+	}
+
+	void setUpdateClockRate(UpdateClock& inOutClock, const UInt32 perSecond)
+	{
+		inOutClock.mPerSecond = perSecond;
+	}
+
+	UInt32 takeDueUpdates(UpdateClock& inOutClock, const UInt64 nowNS, const UInt32 maxUpdates)
+	{
+		if (!inOutClock.mStarted)
+		{
+			inOutClock.mLastNS = nowNS;
+			inOutClock.mStarted = true;
+			return 0;
+		}
+
+		UInt64 credit = getCredit(inOutClock, nowNS);
+		inOutClock.mLastNS = nowNS;
+
+		const UInt64 due = credit / kNSPerSecond;
+		const UInt32 taken = (due < maxUpdates) ? static_cast<UInt32>(due) : maxUpdates;
+		credit -= taken * kNSPerSecond;
+		inOutClock.mCredit = credit;
+		return taken;
+	}
+
+	UInt64 getNSUntilDue(const UpdateClock& clock, const UInt64 nowNS)
+	{
+		if (!clock.mStarted)
+		{
+			return 0;
+		}
+
+		if (clock.mPerSecond == 0)
+		{
+			// Never due, there's no point waking often.
+			return kUpdateClockMaxCatchUpNS;
+		}
+
+		const UInt64 credit = getCredit(clock, nowNS);
+		if (credit >= kNSPerSecond)
+		{
+			return 0;
+		}
+
+		// Rounded up, waking a nanosecond early would find nothing due.
+		return ((kNSPerSecond - credit) + clock.mPerSecond - 1) / clock.mPerSecond;
+	}
+
+} // namespace SynchingFeeling
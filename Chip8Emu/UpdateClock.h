@@ -0,0 +1,32 @@
+#pragma once
+
+#include "EmuTypes.h"
+
+namespace SynchingFeeling
+{
+	static const UInt64 kNSPerSecond = 1000000000;
+	static const UInt64 kNSPerMS = 1000000;
+	static const UInt64 kUpdateClockMaxCatchUpNS = kNSPerSecond / 4;	// Longer stalls (a debugger, a dragged window) are dropped rather than raced through
+
+	// Paces something that happens perSecond times a second against a nanosecond clock.
+	// Elapsed time is counted in nanoseconds times the rate, and whatever fraction of an update is left over carries on to the next take
+	// rather than being rounded away, so the rate holds against wall time from a few hundred a second to millions.
+	struct UpdateClock
+	{
+		UInt64 mLastNS;												// Clock reading at the last take
+		UInt64 mCredit;												// Nanoseconds times mPerSecond not yet handed out as updates
+		UInt32 mPerSecond;
+		bool mStarted;												// False until the first take, which only starts the clock
+	};
+
+	void startUpdateClock(UpdateClock& outClock, const UInt32 perSecond);
+
+	// Changes the rate from now on, time already counted keeps the fraction of an update it was worth.
+	void setUpdateClockRate(UpdateClock& inOutClock, const UInt32 perSecond);
+
+	// Updates due at nowNS, at most maxUpdates, the rest stay due for the next take.
+	UInt32 takeDueUpdates(UpdateClock& inOutClock, const UInt64 nowNS, const UInt32 maxUpdates);
+
+	// Nanoseconds from nowNS until the next update is due, 0 if one already is.
+	UInt64 getNSUntilDue(const UpdateClock& clock, const UInt64 nowNS);
+}
@@ -0,0 +1,339 @@
+#include "Upscale.h"
+
+#include <string.h>
+
+#include "PixelExpand.h"
+
+using namespace std;
+
+namespace SynchingFeeling
+{
+	namespace
+	{
+		static const char* const kUpscaleFilterNames[] =
+		{
+			"nearest",
+			"scale2x",
+			"scale3x"
+		};
+		static const UInt32 kUpscaleFilterCount = sizeof(kUpscaleFilterNames) / sizeof(kUpscaleFilterNames[0]);
+
+#if defined HEADLESS || defined WIN32
+		static const UInt64 kMinThreadedPixels = 128 * 1024;		// Smaller outputs aren't worth waking the workers for
+		static const UInt64 kLeftmostPixel = static_cast<UInt64>(1) << 63;
+
+		// Picks a where mask is set, b elsewhere, for 64 pixels at once.
+		inline UInt64 select(const UInt64 mask, const UInt64 a, const UInt64 b)
+		{
+			return (mask & a) | (~mask & b);
+		}
+
+		// Set where two rows' pixels match.
+		inline UInt64 equal(const UInt64 a, const UInt64 b)
+		{
+			return ~(a ^ b);
+		}
+
+		// Each pixel's left or right neighbour moved into its place, the edge pixels are their own neighbours.
+		inline UInt64 leftOf(const UInt64 row)
+		{
+			return (row >> 1) | (row & kLeftmostPixel);
+		}
+
+		inline UInt64 rightOf(const UInt64 row, const UInt64 rightmostPixel)
+		{
+			return ((row << 1) & ~rightmostPixel) | (row & rightmostPixel);
+		}
+
+		// Interleaves count rows of width pixels into one row count times as wide, pixel x of source k becomes pixel x * count + k.
+		void spreadBits(const UInt64* sources, const UInt32 count, const Int32 width, UInt64* out)
+		{
+			memset(out, 0, count * sizeof(UInt64));
+			UInt32 position = 0;
+			for (Int32 x = 0; x < width; ++x)
+			{
+				for (UInt32 k = 0; k < count; ++k, ++position)
+				{
+					out[position >> 6] |= ((sources[k] << x) >> 63) << (63 - (position & 63));
+				}
+			}
+		}
+
+		// Expands a row of words to RGBA32, 64 pixels a word.
+		void expandBits(const UInt64* words, const Int32 pixels, const PixelColours& colours, UChar* out)
+		{
+			UInt32* pixel = reinterpret_cast<UInt32*>(out);
+			for (Int32 x = 0; x < pixels; x += 64)
+			{
+				expandRowRGBA32(words[x >> 6], ((pixels - x) < 64) ? (pixels - x) : 64, colours, pixel + x);
+			}
+		}
+#endif
+
+	} // namespace
+
+	UInt32 getUpscaleScale(const EUpscaleFilter::Type filter, const UInt32 nearestScale)
+	{
+		switch (filter)
+		{
+			case EUpscaleFilter::Scale2x:
+				return 2;
+			case EUpscaleFilter::Scale3x:
+				return 3;
+			default:
+				return (nearestScale < 1) ? 1 : ((nearestScale > kUpscaleMaxScale) ? kUpscaleMaxScale : nearestScale);
+		}
+	}
+
+	const char* getUpscaleFilterName(const EUpscaleFilter::Type filter)
+	{
+		return (static_cast<UInt32>(filter) < kUpscaleFilterCount) ? kUpscaleFilterNames[filter] : "unknown";
+	}
+
+	bool findUpscaleFilter(const char* name, EUpscaleFilter::Type& outFilter)
+	{
+		for (UInt32 i = 0; i < kUpscaleFilterCount; ++i)
+		{
+			if (strcmp(name, kUpscaleFilterNames[i]) == 0)
+			{
+				outFilter = static_cast<EUpscaleFilter::Type>(i);
+				return true;
+			}
+		}
+		return false;
+	}
+
+#if defined HEADLESS || defined WIN32
+	Upscaler::Upscaler()
+		: mFilter(EUpscaleFilter::Nearest)
+		, mNearestScale(1)
+		, mScale(1)
+		, mGeneration(0)
+		, mPending(0)
+		, mQuit(false)
+	{
+		memset(&mJob, 0, sizeof(mJob));
+	}
+
+	Upscaler::~Upscaler()
+	{
+		stopWorkers();
+	}
+
+	void Upscaler::configure(const EUpscaleFilter::Type filter, const UInt32 nearestScale, const UInt32 workerThreads)
+	{
+		stopWorkers();
+
+		mFilter = filter;
+		mNearestScale = getUpscaleScale(EUpscaleFilter::Nearest, nearestScale);
+		mScale = getUpscaleScale(filter, mNearestScale);
+
+		mQuit = false;
+		for (UInt32 i = 0; i < workerThreads; ++i)
+		{
+			mWorkers.emplace_back(&Upscaler::runWorker, this, i + 1, mGeneration);
+		}
+	}
+
+	UInt32 Upscaler::getAffectedRows(const UInt32 dirtyRows) const
+	{
+		if (mFilter == EUpscaleFilter::Nearest)
+		{
+			return dirtyRows;
+		}
+		return dirtyRows | (dirtyRows << 1) | (dirtyRows >> 1);
+	}
+
+	void Upscaler::upscale(const UInt64* gfx, const Int32 width, const Int32 height, const Int32 firstRow, const Int32 endRow,
+		const PixelColours& colours, UChar* out, const Int32 pitch)
+	{
+		Job job;
+		job.mGfx = gfx;
+		job.mWidth = width;
+		job.mHeight = height;
+		job.mFirstRow = firstRow;
+		job.mEndRow = endRow;
+		job.mColours = &colours;
+		job.mOut = out;
+		job.mPitch = pitch;
+
+		const UInt64 pixels = static_cast<UInt64>(endRow - firstRow) * width * mScale * mScale;
+		if (mWorkers.empty() || pixels < kMinThreadedPixels)
+		{
+			upscaleBand(job, 0, 1);
+			return;
+		}
+
+		const UInt32 bands = static_cast<UInt32>(mWorkers.size()) + 1;
+		{
+			lock_guard<mutex> lock(mMutex);
+			mJob = job;
+			mPending = static_cast<UInt32>(mWorkers.size());
+			++mGeneration;
+		}
+		mStart.notify_all();
+
+		upscaleBand(job, 0, bands);
+
+		unique_lock<mutex> lock(mMutex);
+		mDone.wait(lock, [this]() { return mPending == 0; });
+	}
+
+	void Upscaler::stopWorkers()
+	{
+		{
+			lock_guard<mutex> lock(mMutex);
+			mQuit = true;
+		}
+		mStart.notify_all();
+
+		for (thread& worker : mWorkers)
+		{
+			worker.join();
+		}
+		mWorkers.clear();
+	}
+
+	void Upscaler::runWorker(const UInt32 band, UInt32 generation)
+	{
+		for (;;)
+		{
+			Job job;
+			UInt32 bands = 0;
+			{
+				unique_lock<mutex> lock(mMutex);
+				mStart.wait(lock, [this, generation]() { return mQuit || mGeneration != generation; });
+				if (mQuit)
+				{
+					return;
+				}
+				generation = mGeneration;
+				job = mJob;
+				bands = static_cast<UInt32>(mWorkers.size()) + 1;
+			}
+
+			upscaleBand(job, band, bands);
+
+			{
+				lock_guard<mutex> lock(mMutex);
+				--mPending;
+			}
+			mDone.notify_one();
+		}
+	}
+
+	void Upscaler::upscaleBand(const Job& job, const UInt32 band, const UInt32 bands) const
+	{
+		const Int32 rows = job.mEndRow - job.mFirstRow;
+		const Int32 first = job.mFirstRow + ((rows * static_cast<Int32>(band)) / static_cast<Int32>(bands));
+		const Int32 end = job.mFirstRow + ((rows * static_cast<Int32>(band + 1)) / static_cast<Int32>(bands));
+		for (Int32 y = first; y < end; ++y)
+		{
+			upscaleRow(job, y);
+		}
+	}
+
+	void Upscaler::upscaleRow(const Job& job, const Int32 y) const
+	{
+		const Int32 width = job.mWidth;
+		const Int32 outWidth = width * static_cast<Int32>(mScale);
+		const UInt32 rowBytes = static_cast<UInt32>(outWidth) * sizeof(UInt32);
+		UChar* out = job.mOut + ((y - job.mFirstRow) * static_cast<Int32>(mScale) * job.mPitch);
+
+		const UInt64 rightmostPixel = static_cast<UInt64>(1) << (64 - width);
+		const UInt64 e = job.mGfx[y];
+		UInt64 sources[kUpscaleMaxScale];
+		UInt64 bits[kUpscaleMaxScale];
+
+		switch (mFilter)
+		{
+			case EUpscaleFilter::Nearest:
+			{
+				// Every output row is the same, the first is expanded and copied down.
+				for (UInt32 k = 0; k < mScale; ++k)
+				{
+					sources[k] = e;
+				}
+				spreadBits(sources, mScale, width, bits);
+				expandBits(bits, outWidth, *job.mColours, out);
+				for (UInt32 r = 1; r < mScale; ++r)
+				{
+					memcpy(out + (r * job.mPitch), out, rowBytes);
+				}
+				break;
+			}
+
+			case EUpscaleFilter::Scale2x:
+			{
+				//   A
+				// C P B
+				//   D
+				const UInt64 a = job.mGfx[(y > 0) ? y - 1 : y];
+				const UInt64 d = job.mGfx[(y + 1 < job.mHeight) ? y + 1 : y];
+				const UInt64 c = leftOf(e);
+				const UInt64 b = rightOf(e, rightmostPixel);
+				const UInt64 eqCA = equal(c, a);
+				const UInt64 eqCD = equal(c, d);
+				const UInt64 eqAB = equal(a, b);
+				const UInt64 eqBD = equal(b, d);
+
+				// A corner takes its two neighbours' colour where they agree and the other two don't.
+				sources[0] = select(eqCA & ~eqCD & ~eqAB, a, e);
+				sources[1] = select(eqAB & ~eqCA & ~eqBD, b, e);
+				spreadBits(sources, 2, width, bits);
+				expandBits(bits, outWidth, *job.mColours, out);
+
+				sources[0] = select(eqCD & ~eqBD & ~eqCA, c, e);
+				sources[1] = select(eqBD & ~eqAB & ~eqCD, d, e);
+				spreadBits(sources, 2, width, bits);
+				expandBits(bits, outWidth, *job.mColours, out + job.mPitch);
+				break;
+			}
+
+			case EUpscaleFilter::Scale3x:
+			{
+				// A B C
+				// D E F
+				// G H I
+				const UInt64 b = job.mGfx[(y > 0) ? y - 1 : y];
+				const UInt64 h = job.mGfx[(y + 1 < job.mHeight) ? y + 1 : y];
+				const UInt64 a = leftOf(b);
+				const UInt64 c = rightOf(b, rightmostPixel);
+				const UInt64 d = leftOf(e);
+				const UInt64 f = rightOf(e, rightmostPixel);
+				const UInt64 g = leftOf(h);
+				const UInt64 i = rightOf(h, rightmostPixel);
+
+				const UInt64 eqDB = equal(d, b);
+				const UInt64 eqBF = equal(b, f);
+				const UInt64 eqDH = equal(d, h);
+				const UInt64 eqHF = equal(h, f);
+				const UInt64 topLeft = eqDB & ~eqBF & ~eqDH;
+				const UInt64 topRight = eqBF & ~eqDB & ~eqHF;
+				const UInt64 bottomLeft = eqDH & ~eqDB & ~eqHF;
+				const UInt64 bottomRight = eqHF & ~eqDH & ~eqBF;
+
+				sources[0] = select(topLeft, d, e);
+				sources[1] = select((topLeft & (e ^ c)) | (topRight & (e ^ a)), b, e);
+				sources[2] = select(topRight, f, e);
+				spreadBits(sources, 3, width, bits);
+				expandBits(bits, outWidth, *job.mColours, out);
+
+				sources[0] = select((topLeft & (e ^ g)) | (bottomLeft & (e ^ a)), d, e);
+				sources[1] = e;
+				sources[2] = select((topRight & (e ^ i)) | (bottomRight & (e ^ c)), f, e);
+				spreadBits(sources, 3, width, bits);
+				expandBits(bits, outWidth, *job.mColours, out + job.mPitch);
+
+				sources[0] = select(bottomLeft, d, e);
+				sources[1] = select((bottomLeft & (e ^ i)) | (bottomRight & (e ^ g)), h, e);
+				sources[2] = select(bottomRight, f, e);
+				spreadBits(sources, 3, width, bits);
+				expandBits(bits, outWidth, *job.mColours, out + (2 * job.mPitch));
+				break;
+			}
+		}
+	}
+#endif
+
+} // namespace SynchingFeeling
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "EmuTypes.h"
+
+#if defined HEADLESS || defined WIN32
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+namespace SynchingFeeling
+{
+	struct PixelColours;
+
+	// How a frame is scaled up on the CPU before it reaches the texture.
+	namespace EUpscaleFilter
+	{
+		enum Type
+		{
+			Nearest,		// Each pixel becomes a square block, any whole scale
+			Scale2x,		// EPX, diagonal edges smoothed, 2x
+			Scale3x			// As Scale2x at 3x
+		};
+	};
+
+	static const UInt32 kUpscaleMaxScale = 16;						// Largest Nearest scale
+
+	// Output scale of a filter, nearestScale only applies to Nearest.
+	UInt32 getUpscaleScale(const EUpscaleFilter::Type filter, const UInt32 nearestScale);
+
+	// Name for reports, and back from one, false if it isn't known.
+	const char* getUpscaleFilterName(const EUpscaleFilter::Type filter);
+	bool findUpscaleFilter(const char* name, EUpscaleFilter::Type& outFilter);
+
+#if defined HEADLESS || defined WIN32
+	// Upscales frames (one word per row, leftmost pixel in the top bit) to RGBA32.
+	// The filters work on whole rows of bits at a time, 64 pixels per operation, and the result is expanded with the pixel expansion kernels.
+	// Big outputs are split by rows over worker threads, the calling thread takes a share too.
+	class Upscaler
+	{
+	public:
+		Upscaler();
+		~Upscaler();
+
+		// workerThreads is in addition to the caller, 0 upscales on the calling thread only.
+		void configure(const EUpscaleFilter::Type filter, const UInt32 nearestScale, const UInt32 workerThreads);
+
+		EUpscaleFilter::Type getFilter() const { return mFilter; }
+		UInt32 getScale() const { return mScale; }
+
+		// Source rows whose output changes when dirtyRows change, Scale2x and Scale3x look at the rows either side.
+		UInt32 getAffectedRows(const UInt32 dirtyRows) const;
+
+		// Upscales source rows [firstRow, endRow) of a width x height frame, width is at most 64.
+		// out is the output row for firstRow (firstRow * scale in the whole image), pitch is in bytes.
+		void upscale(const UInt64* gfx, const Int32 width, const Int32 height, const Int32 firstRow, const Int32 endRow,
+			const PixelColours& colours, UChar* out, const Int32 pitch);
+
+	private:
+		Upscaler(const Upscaler&);
+		Upscaler& operator=(const Upscaler&);
+
+		// One call's worth of work, shared with the workers.
+		struct Job
+		{
+			const UInt64* mGfx;
+			Int32 mWidth;
+			Int32 mHeight;
+			Int32 mFirstRow;
+			Int32 mEndRow;
+			const PixelColours* mColours;
+			UChar* mOut;
+			Int32 mPitch;
+		};
+
+		void stopWorkers();
+		// generation is taken when the worker is created, so a job handed out before it first waits isn't missed.
+		void runWorker(const UInt32 band, UInt32 generation);
+		void upscaleBand(const Job& job, const UInt32 band, const UInt32 bands) const;
+		void upscaleRow(const Job& job, const Int32 y) const;
+
+		EUpscaleFilter::Type mFilter;
+		UInt32 mNearestScale;
+		UInt32 mScale;
+
+		std::vector<std::thread> mWorkers;
+		std::mutex mMutex;
+		std::condition_variable mStart;								// Workers wait here for the next job
+		std::condition_variable mDone;								// The caller waits here for the workers to finish
+		Job mJob;
+		UInt32 mGeneration;											// Bumped for every job handed out
+		UInt32 mPending;											// Workers still busy with the current job
+		bool mQuit;
+	};
+#endif
+}
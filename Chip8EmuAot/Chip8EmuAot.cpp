@@ -0,0 +1,567 @@
+// Chip8EmuAot.cpp : Ahead of time recompiler.
+//
+// Walks a ROM's control flow from kPCStart and writes a C++ translation unit that runs it as straight line code, one label per
+// basic block. Compile the output into the build (CHIP8_AOT_ROMS) and attach it with Chip8Machine::setCompiledProgram.
+// V0-VF live in locals, only written back around handler calls and on the way out.
+// Computed jumps (BNNN), returns and anything that isn't reached statically go through a switch on PC, code the walk never
+// found and code that has been modified at run time is left to the interpreter.
+//
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Chip8Emu/Machine.h"
+
+using namespace std;
+using namespace SynchingFeeling;
+
+namespace
+{
+	struct Block
+	{
+		UShort mStart;
+		UShort mEnd;
+		UInt32 mIndex;
+	};
+
+	class Compiler
+	{
+	public:
+		Compiler(const vector<UChar>& rom)
+			: mRom(rom)
+			, mVisited(kMemorySize, false)
+			, mLeader(kMemorySize, false)
+		{
+		}
+
+		void walk();
+		void write(ostream& out, const string& name, const string& romName) const;
+
+	private:
+		bool inRom(const UInt32 pc) const
+		{
+			return (pc >= kPCStart) && ((pc & 0x1) == 0) && (pc + sizeof(UShort) <= kPCStart + mRom.size());
+		}
+
+		DecodedOp decodeAt(const UShort pc) const
+		{
+			return decodeOpCode(static_cast<UShort>((mRom[pc - kPCStart] << 8) | mRom[pc - kPCStart + 1]));
+		}
+
+		static bool isTerminator(const DecodedOp& op);
+		static bool usesHandler(const DecodedOp& op);
+		void addTarget(const UInt32 pc, vector<UShort>& work);
+		string jumpTo(const UInt32 pc) const;
+		void writeInstruction(ostream& out, const UShort pc, const DecodedOp& op, const UShort blockEnd) const;
+
+		const vector<UChar>& mRom;
+		vector<bool> mVisited;
+		vector<bool> mLeader;
+		vector<Block> mBlocks;
+	};
+
+	string hex(const UInt32 value, const UInt32 digits)
+	{
+		char text[16];
+		snprintf(text, sizeof(text), "0x%0*X", static_cast<int>(digits), value);
+		return text;
+	}
+
+	string label(const UInt32 pc)
+	{
+		return "Block" + hex(pc, 3).substr(2);
+	}
+
+	string opName(const UShort pc)
+	{
+		return "kOp" + hex(pc, 3).substr(2);
+	}
+
+	// V0-VF as locals in generated code.
+	string reg(const UInt32 index)
+	{
+		return "v" + hex(index, 1).substr(2);
+	}
+
+	string loadRegisters()
+	{
+		string text;
+		for (UInt32 i = 0; i < kRegisterCount; ++i)
+		{
+			text += reg(i) + " = state.mV[" + hex(i, 1) + "];" + ((i + 1 < kRegisterCount) ? " " : "");
+		}
+		return text;
+	}
+
+	string storeRegisters()
+	{
+		string text;
+		for (UInt32 i = 0; i < kRegisterCount; ++i)
+		{
+			text += "state.mV[" + hex(i, 1) + "] = " + reg(i) + ";" + ((i + 1 < kRegisterCount) ? " " : "");
+		}
+		return text;
+	}
+
+	bool Compiler::isTerminator(const DecodedOp& op)
+	{
+		switch (op.mOpId)
+		{
+		case EOpId::OpCode00E0:
+		case EOpId::OpCode6XNN:
+		case EOpId::OpCode7XNN:
+		case EOpId::OpCode8XY0:
+		case EOpId::OpCode8XY1:
+		case EOpId::OpCode8XY2:
+		case EOpId::OpCode8XY3:
+		case EOpId::OpCode8XY4:
+		case EOpId::OpCode8XY5:
+		case EOpId::OpCode8XY6:
+		case EOpId::OpCode8XY7:
+		case EOpId::OpCode8XYE:
+		case EOpId::OpCodeANNN:
+		case EOpId::OpCodeCXNN:
+		case EOpId::OpCodeDXYN:
+		case EOpId::OpCodeFX07:
+		case EOpId::OpCodeFX15:
+		case EOpId::OpCodeFX18:
+		case EOpId::OpCodeFX1E:
+		case EOpId::OpCodeFX29:
+		case EOpId::OpCodeFX65:
+			return false;
+		default:
+			return true;
+		}
+	}
+
+	bool Compiler::usesHandler(const DecodedOp& op)
+	{
+		switch (op.mOpId)
+		{
+		case EOpId::OpCode1NNN:
+		case EOpId::OpCode2NNN:
+		case EOpId::OpCode00EE:
+		case EOpId::OpCode3XNN:
+		case EOpId::OpCode4XNN:
+		case EOpId::OpCode5XY0:
+		case EOpId::OpCode9XY0:
+		case EOpId::OpCodeBNNN:
+			return false;
+		default:
+			return isTerminator(op) || (op.mOpId == EOpId::OpCode00E0) || (op.mOpId == EOpId::OpCodeCXNN) || (op.mOpId == EOpId::OpCodeDXYN)
+				|| (op.mOpId == EOpId::OpCodeFX29) || (op.mOpId == EOpId::OpCodeFX65);
+		}
+	}
+
+	void Compiler::addTarget(const UInt32 pc, vector<UShort>& work)
+	{
+		if (inRom(pc))
+		{
+			mLeader[pc] = true;
+			work.push_back(static_cast<UShort>(pc));
+		}
+	}
+
+	void Compiler::walk()
+	{
+		vector<UShort> work;
+		addTarget(kPCStart, work);
+
+		while (!work.empty())
+		{
+			const UShort pc = work.back();
+			work.pop_back();
+			if (!inRom(pc) || mVisited[pc])
+			{
+				continue;
+			}
+			mVisited[pc] = true;
+
+			const DecodedOp op = decodeAt(pc);
+			const UInt32 next = pc + sizeof(UShort);
+			switch (op.mOpId)
+			{
+			case EOpId::OpCode1NNN:
+				addTarget(op.mNNN, work);
+				break;
+			case EOpId::OpCode2NNN:
+				addTarget(op.mNNN, work);
+				addTarget(next, work);				// Where 00EE comes back to
+				break;
+			case EOpId::OpCode3XNN:
+			case EOpId::OpCode4XNN:
+			case EOpId::OpCode5XY0:
+			case EOpId::OpCode9XY0:
+			case EOpId::OpCodeEX9E:
+			case EOpId::OpCodeEXA1:
+				addTarget(next, work);
+				addTarget(next + sizeof(UShort), work);
+				break;
+			case EOpId::OpCodeFX0A:
+				addTarget(pc, work);				// Waits by running itself again
+				addTarget(next, work);
+				break;
+			case EOpId::OpCodeFX33:
+			case EOpId::OpCodeFX55:
+				addTarget(next, work);
+				break;
+			case EOpId::OpCode00EE:
+			case EOpId::OpCodeBNNN:
+			case EOpId::OpCode0NNN:
+			case EOpId::OpCodeInvalid:
+				break;
+			default:
+				work.push_back(static_cast<UShort>(next));
+				break;
+			}
+		}
+
+		// Split what was reached into blocks, one per leader.
+		for (UInt32 pc = kPCStart; pc < kMemorySize; pc += sizeof(UShort))
+		{
+			if (!mVisited[pc] || !mLeader[pc])
+			{
+				continue;
+			}
+
+			Block block;
+			block.mStart = static_cast<UShort>(pc);
+			block.mIndex = static_cast<UInt32>(mBlocks.size());
+			UInt32 end = pc;
+			for (;;)
+			{
+				const DecodedOp op = decodeAt(static_cast<UShort>(end));
+				end += sizeof(UShort);
+				if (isTerminator(op) || !inRom(end) || !mVisited[end] || mLeader[end])
+				{
+					break;
+				}
+			}
+			block.mEnd = static_cast<UShort>(end);
+			mBlocks.push_back(block);
+		}
+	}
+
+	string Compiler::jumpTo(const UInt32 pc) const
+	{
+		if (inRom(pc) && mVisited[pc] && mLeader[pc])
+		{
+			return "goto " + label(pc) + ";";
+		}
+		return "state.mPC = " + hex(pc & 0xFFFF, 3) + "; goto Exit;";
+	}
+
+	void Compiler::writeInstruction(ostream& out, const UShort pc, const DecodedOp& op, const UShort blockEnd) const
+	{
+		const bool last = (pc + sizeof(UShort) == blockEnd);
+		const string x = hex(op.mX, 1);
+		const string y = hex(op.mY, 1);
+		const string nn = hex(op.mNN, 2);
+		const string nnn = hex(op.mNNN, 3);
+		const string vx = reg(op.mX);
+		const string vy = reg(op.mY);
+		const UInt32 next = pc + sizeof(UShort);
+		const string indent = "\t\t\t";
+		// Timers that follow the instruction count are brought up to this instruction, budget being what's left once the whole block is paid for.
+		const string syncTimers = "syncTimers(state, state.mRunEndCycle - budget - " + to_string((blockEnd - pc) / sizeof(UShort)) + ");";
+
+		out << indent << "// " << hex(pc, 3) << ": " << hex(op.mOpCode, 4) << "\n";
+		switch (op.mOpId)
+		{
+		case EOpId::OpCode1NNN:
+			out << indent << jumpTo(op.mNNN) << "\n";
+			break;
+		case EOpId::OpCode2NNN:
+			out << indent << "state.mStack[state.mSP++] = " << hex(pc, 3) << ";\n";
+			out << indent << jumpTo(op.mNNN) << "\n";
+			break;
+		case EOpId::OpCode00EE:
+			out << indent << "state.mPC = state.mStack[--state.mSP] + 2;\n";
+			out << indent << "goto Dispatch;\n";
+			break;
+		case EOpId::OpCode3XNN:
+		case EOpId::OpCode4XNN:
+		case EOpId::OpCode5XY0:
+		case EOpId::OpCode9XY0:
+		{
+			const char* compare = ((op.mOpId == EOpId::OpCode3XNN) || (op.mOpId == EOpId::OpCode5XY0)) ? " == " : " != ";
+			const string rhs = ((op.mOpId == EOpId::OpCode3XNN) || (op.mOpId == EOpId::OpCode4XNN)) ? nn : vy;
+			if (rhs == vx)
+			{
+				// Comparing a register with itself, always skips (5XX0) or never does (9XX0).
+				out << indent << jumpTo((op.mOpId == EOpId::OpCode5XY0) ? next + sizeof(UShort) : next) << "\n";
+				break;
+			}
+			out << indent << "if (" << vx << compare << rhs << ") { " << jumpTo(next + sizeof(UShort)) << " }\n";
+			out << indent << jumpTo(next) << "\n";
+			break;
+		}
+		case EOpId::OpCode6XNN:
+			out << indent << vx << " = " << nn << ";\n";
+			break;
+		case EOpId::OpCode7XNN:
+			out << indent << vx << " += " << nn << ";\n";
+			break;
+		case EOpId::OpCode8XY0:
+			out << indent << vx << " = " << vy << ";\n";
+			break;
+		case EOpId::OpCode8XY1:
+			out << indent << vx << " |= " << vy << ";\n";
+			break;
+		case EOpId::OpCode8XY2:
+			out << indent << vx << " &= " << vy << ";\n";
+			break;
+		case EOpId::OpCode8XY3:
+			out << indent << vx << " ^= " << vy << ";\n";
+			break;
+		case EOpId::OpCode8XY4:
+			// The interpreter's flag rules, VF from the 16 bit result and written before VX.
+			out << indent << "{ const UShort sum = " << vx << " + " << vy << "; vF = (sum / 0xFF != 0) ? 0x01 : 0x00; " << vx << " = static_cast<UChar>(sum); }\n";
+			break;
+		case EOpId::OpCode8XY5:
+			out << indent << "{ const UShort minus = static_cast<UShort>(" << vx << " - " << vy << "); vF = (minus / 0xFF != 0) ? 0x00 : 0x01; " << vx << " = static_cast<UChar>(minus); }\n";
+			break;
+		case EOpId::OpCode8XY7:
+			out << indent << "{ const UShort minus = static_cast<UShort>(" << vy << " - " << vx << "); vF = (minus / 0xFF != 0) ? 0x00 : 0x01; " << vx << " = static_cast<UChar>(minus); }\n";
+			break;
+		case EOpId::OpCode8XY6:
+			out << indent << vx << " = " << vy << " >> 1; " << vy << " = " << vy << " & 0x01;\n";
+			break;
+		case EOpId::OpCode8XYE:
+			out << indent << vx << " = static_cast<UChar>(" << vy << " << 1); " << vy << " = " << vy << " & 0x80;\n";
+			break;
+		case EOpId::OpCodeANNN:
+			out << indent << "state.mI = " << nnn << ";\n";
+			break;
+		case EOpId::OpCodeBNNN:
+			out << indent << "state.mPC = static_cast<UShort>(v0 + " << nnn << " + 2);\n";
+			out << indent << "goto Dispatch;\n";
+			break;
+		case EOpId::OpCodeFX07:
+			out << indent << syncTimers << " " << vx << " = state.mDelayTimer;\n";
+			break;
+		case EOpId::OpCodeFX15:
+			out << indent << syncTimers << " state.mDelayTimer = " << vx << ";\n";
+			break;
+		case EOpId::OpCodeFX18:
+			out << indent << syncTimers << " state.mSoundTimer = " << vx << ";\n";
+			break;
+		case EOpId::OpCodeFX1E:
+			out << indent << "state.mI += " << vx << ";\n";
+			break;
+		case EOpId::OpCode00E0:
+		case EOpId::OpCodeCXNN:
+		case EOpId::OpCodeDXYN:
+		case EOpId::OpCodeFX29:
+		case EOpId::OpCodeFX65:
+			out << indent << storeRegisters() << "\n";
+			out << indent << "compiledCall(state, " << opName(pc) << ");\n";
+			out << indent << loadRegisters() << "\n";
+			break;
+		case EOpId::OpCodeFX33:
+		case EOpId::OpCodeFX55:
+			// Back to the machine so it can drop anything decoded from what was written.
+			out << indent << storeRegisters() << "\n";
+			out << indent << "compiledCall(state, " << opName(pc) << ");\n";
+			out << indent << "state.mPC = " << hex(next, 3) << ";\n";
+			out << indent << "outWriteLength = " << static_cast<UInt32>(op.mWriteLength) << ";\n";
+			out << indent << "return budget;\n";
+			break;
+		default:
+			// Key skips, key waits and anything unrecognised, the handler decides where PC goes.
+			out << indent << "state.mPC = " << hex(pc, 3) << ";\n";
+			out << indent << storeRegisters() << "\n";
+			out << indent << "if (compiledCall(state, " << opName(pc) << ")) { state.mPC += 2; }\n";
+			out << indent << loadRegisters() << "\n";
+			out << indent << "goto Dispatch;\n";
+			break;
+		}
+
+		if (last && !isTerminator(op))
+		{
+			out << indent << jumpTo(next) << "\n";
+		}
+	}
+
+	void Compiler::write(ostream& out, const string& name, const string& romName) const
+	{
+		out << "// Generated by chip8aot from " << romName << ", do not edit.\n";
+		out << "#include \"Chip8Emu/Aot.h\"\n\n";
+		out << "namespace SynchingFeeling\n{\n\tnamespace\n\t{\n";
+
+		out << "\t\tstatic const UChar kRom[] =\n\t\t{";
+		for (size_t i = 0; i < mRom.size(); ++i)
+		{
+			out << (((i % 16) == 0) ? "\n\t\t\t" : " ") << hex(mRom[i], 2) << ",";
+		}
+		out << "\n\t\t};\n\n";
+
+		out << "\t\tstatic const CompiledBlock kBlocks[] =\n\t\t{\n";
+		for (const Block& block : mBlocks)
+		{
+			out << "\t\t\t{ " << hex(block.mStart, 3) << ", " << hex(block.mEnd, 3) << " },\n";
+		}
+		if (mBlocks.empty())
+		{
+			out << "\t\t\t{ 0, 0 },\n";
+		}
+		out << "\t\t};\n\n";
+
+		// Decoded once at startup, for everything that runs through its handler.
+		bool anyDecoded = false;
+		for (const Block& block : mBlocks)
+		{
+			for (UInt32 pc = block.mStart; pc < block.mEnd; pc += sizeof(UShort))
+			{
+				const DecodedOp op = decodeAt(static_cast<UShort>(pc));
+				if (!usesHandler(op))
+				{
+					continue;
+				}
+				out << "\t\tstatic const DecodedOp " << opName(static_cast<UShort>(pc)) << " = decodeOpCode(" << hex(op.mOpCode, 4) << ");\n";
+				anyDecoded = true;
+			}
+		}
+		if (anyDecoded)
+		{
+			out << "\n";
+		}
+
+		out << "\t\tUInt32 run(Chip8State& state, const UChar* blockValid, UInt32 budget, UInt32& outWriteLength)\n\t\t{\n";
+		out << "\t\t\tUChar ";
+		for (UInt32 i = 0; i < kRegisterCount; ++i)
+		{
+			out << reg(i) << ((i + 1 < kRegisterCount) ? ", " : ";\n");
+		}
+		out << "\t\t\t" << loadRegisters() << "\n";
+		out << "\t\t\tgoto Dispatch;\n\n";
+
+		for (const Block& block : mBlocks)
+		{
+			const UInt32 count = (block.mEnd - block.mStart) / sizeof(UShort);
+			out << "\t\t" << label(block.mStart) << ":\n";
+			out << "\t\t\tif ((blockValid[" << block.mIndex << "] == 0) || (budget < " << count << ")) { state.mPC = " << hex(block.mStart, 3) << "; goto Exit; }\n";
+			out << "\t\t\tbudget -= " << count << ";\n";
+			for (UInt32 pc = block.mStart; pc < block.mEnd; pc += sizeof(UShort))
+			{
+				writeInstruction(out, static_cast<UShort>(pc), decodeAt(static_cast<UShort>(pc)), block.mEnd);
+			}
+			out << "\n";
+		}
+
+		out << "\t\tDispatch:\n";
+		out << "\t\t\tswitch (state.mPC)\n\t\t\t{\n";
+		for (const Block& block : mBlocks)
+		{
+			out << "\t\t\tcase " << hex(block.mStart, 3) << ": goto " << label(block.mStart) << ";\n";
+		}
+		out << "\t\t\tdefault: goto Exit;\n";
+		out << "\t\t\t}\n\n";
+		out << "\t\tExit:\n";
+		out << "\t\t\t" << storeRegisters() << "\n";
+		out << "\t\t\treturn budget;\n";
+		out << "\t\t}\n";
+		out << "\t} // namespace\n\n";
+
+		out << "\textern const CompiledProgram gCompiledProgram_" << name << ";\n";
+		out << "\tconst CompiledProgram gCompiledProgram_" << name << " = { \"" << name << "\", kRom, sizeof(kRom), kBlocks, "
+			<< mBlocks.size() << ", &run };\n";
+		out << "}\n";
+	}
+
+	void writeRegistry(ostream& out, const vector<string>& names)
+	{
+		out << "// Generated by chip8aot, do not edit.\n";
+		out << "#include \"Chip8Emu/Aot.h\"\n\n";
+		out << "#include <string.h>\n\n";
+		out << "namespace SynchingFeeling\n{\n";
+		for (const string& name : names)
+		{
+			out << "\textern const CompiledProgram gCompiledProgram_" << name << ";\n";
+		}
+		out << "\n\tconst CompiledProgram* findCompiledProgram(const UChar* rom, const UInt32 size)\n\t{\n";
+		out << "\t\tstatic const CompiledProgram* const kPrograms[] =\n\t\t{\n";
+		for (const string& name : names)
+		{
+			out << "\t\t\t&gCompiledProgram_" << name << ",\n";
+		}
+		out << "\t\t\tnullptr\n\t\t};\n\n";
+		out << "\t\tfor (const CompiledProgram* const* program = kPrograms; *program; ++program)\n\t\t{\n";
+		out << "\t\t\tif (((*program)->mRomSize == size) && (memcmp((*program)->mRom, rom, size) == 0))\n\t\t\t{\n";
+		out << "\t\t\t\treturn *program;\n\t\t\t}\n\t\t}\n";
+		out << "\t\treturn nullptr;\n\t}\n}\n";
+	}
+
+	void printUsage()
+	{
+		cout << "usage: chip8aot <game> <output.cpp> [--name <identifier>]" << endl;
+		cout << "       chip8aot --registry <output.cpp> [identifier...]" << endl;
+	}
+
+	bool writeFile(const char* fileName, const string& text)
+	{
+		ofstream stream(fileName, ios::out | ios::binary);
+		if (!stream.is_open())
+		{
+			return false;
+		}
+		stream << text;
+		return stream.good();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		printUsage();
+		return 1;
+	}
+
+	const string first(argv[1]);
+	ostringstream out;
+	if (first == "--registry")
+	{
+		writeRegistry(out, vector<string>(argv + 3, argv + argc));
+	}
+	else
+	{
+		string name = "rom";
+		if (argc == 5 && string(argv[3]) == "--name")
+		{
+			name = argv[4];
+		}
+		else if (argc != 3)
+		{
+			printUsage();
+			return 1;
+		}
+
+		ifstream stream(argv[1], ios::in | ios::binary);
+		if (!stream.is_open())
+		{
+			cerr << "Could not load game: " << argv[1] << endl;
+			return 1;
+		}
+		vector<UChar> rom((istreambuf_iterator<char>(stream)), istreambuf_iterator<char>());
+		if (rom.size() > kMemorySize - kPCStart)
+		{
+			rom.resize(kMemorySize - kPCStart);
+		}
+
+		Compiler compiler(rom);
+		compiler.walk();
+		compiler.write(out, name, argv[1]);
+	}
+
+	if (!writeFile(argv[2], out.str()))
+	{
+		cerr << "Could not write: " << argv[2] << endl;
+		return 1;
+	}
+	return 0;
+}
\ No newline at end of file
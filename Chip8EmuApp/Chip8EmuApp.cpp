@@ -9,17 +9,47 @@
 using namespace std;
 using namespace SynchingFeeling;
 
+namespace
+{
+	// Nearest upscales to the full window size.
+	static const UInt32 kNearestUpscaleScale = 10;
+}
+
 int _tmain(int argc, _TCHAR *argv[])
 {
-	if (argc != 2)
+	EmuConfig config;
+	bool validArgs = (argc >= 2);
+	for (int i = 2; i < argc && validArgs; ++i)
+	{
+		wstring wideArg(argv[i]);
+		const string arg(wideArg.begin(), wideArg.end());
+		if (arg == "phosphor")
+		{
+			config.mPhosphorDecay = kDefaultPhosphorDecay;
+		}
+		else if (findSpeedMode(arg.c_str(), config.mSpeedMode, config.mSpeedMultiplier))
+		{
+			continue;
+		}
+		else
+		{
+			validArgs = findUpscaleFilter(arg.c_str(), config.mUpscaleFilter);
+			config.mUpscaleScale = kNearestUpscaleScale;
+		}
+	}
+
+	if (!validArgs)
 	{
 		cout << "Chip8Emu (Interpreter)" << endl;
 		cout << " - Requires one argument, which should be the game to load." << endl;
+		cout << " - Optionally followed by a CPU upscaling filter: nearest, scale2x or scale3x." << endl;
+		cout << " - And/or phosphor, so cleared pixels fade out rather than flicker." << endl;
+		cout << " - And/or a speed: realtime, <N>x (e.g. 4x) or uncapped." << endl;
 	}
 	else
 	{
 		wstring wideGame(argv[1]);
-		mainLoop(string(wideGame.begin(), wideGame.end()).c_str());
+		mainLoop(string(wideGame.begin(), wideGame.end()).c_str(), config, nullptr);
 	}
 	return 0;
 }
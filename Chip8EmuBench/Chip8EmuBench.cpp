@@ -0,0 +1,884 @@
+// Chip8EmuBench.cpp : Core throughput benchmark.
+//
+// Runs a number of independent machines spread over a number of threads and reports instructions per second.
+// Uses a built in workload unless a ROM is given.
+//
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "Chip8Emu/Aot.h"
+#include "Chip8Emu/Beeper.h"
+#include "Chip8Emu/Emu.h"
+#include "Chip8Emu/Machine.h"
+#include "Chip8Emu/Phosphor.h"
+#include "Chip8Emu/PixelExpand.h"
+#include "Chip8Emu/UpdateClock.h"
+#include "Chip8Emu/Upscale.h"
+#ifdef HEADLESS
+#include "Chip8Emu/PlatformHeadless.h"
+#endif
+
+using namespace std;
+using namespace SynchingFeeling;
+
+namespace
+{
+	// Arithmetic, skips and jumps only.
+	static const UChar kComputeWorkload[] =
+	{
+		0x60, 0x00,	// 200: V0 = 0
+		0x61, 0x01,	// 202: V1 = 1
+		0x80, 0x14,	// 204: V0 += V1
+		0x71, 0x01,	// 206: V1 += 1
+		0x82, 0x03,	// 208: V2 ^= V0
+		0x83, 0x25,	// 20A: V3 -= V2
+		0xA3, 0x00,	// 20C: I = 0x300
+		0xF2, 0x1E,	// 20E: I += V2
+		0x31, 0x00,	// 210: skip if V1 == 0
+		0x12, 0x04,	// 212: jump 204
+		0x12, 0x00,	// 214: jump 200
+	};
+
+	// As above with a font sprite drawn every pass, kept on screen by masking X and Y.
+	static const UChar kMixedWorkload[] =
+	{
+		0x60, 0x00,	// 200: V0 = 0
+		0x61, 0x01,	// 202: V1 = 1
+		0x63, 0x37,	// 204: V3 = 0x37
+		0x64, 0x0F,	// 206: V4 = 0x0F
+		0x80, 0x14,	// 208: V0 += V1
+		0x71, 0x01,	// 20A: V1 += 1
+		0x85, 0x03,	// 20C: V5 ^= V0
+		0x86, 0x30,	// 20E: V6 = V3
+		0x86, 0x52,	// 210: V6 &= V5
+		0x87, 0x40,	// 212: V7 = V4
+		0x87, 0x02,	// 214: V7 &= V0
+		0xF0, 0x29,	// 216: I = font(V0)
+		0xD6, 0x75,	// 218: draw 8x5 at V6, V7
+		0x31, 0x00,	// 21A: skip if V1 == 0
+		0x12, 0x08,	// 21C: jump 208
+		0x12, 0x00,	// 21E: jump 200
+	};
+
+	// Sets both timers and reads the delay timer down to zero, adding every value read into V2.
+	static const UChar kTimersWorkload[] =
+	{
+		0x60, 0xFF,	// 200: V0 = 0xFF
+		0xF0, 0x15,	// 202: delay = V0
+		0xF0, 0x18,	// 204: sound = V0
+		0xF1, 0x07,	// 206: V1 = delay
+		0x82, 0x14,	// 208: V2 += V1
+		0x31, 0x00,	// 20A: skip if V1 == 0
+		0x12, 0x06,	// 20C: jump 206
+		0x12, 0x00,	// 20E: jump 200
+	};
+
+	// Nothing but CXNN, a random byte into each register in turn.
+	static const UChar kRandWorkload[] =
+	{
+		0xC0, 0xFF, 0xC1, 0xFF, 0xC2, 0xFF, 0xC3, 0xFF,	// 200: V0-V3 = rand
+		0xC4, 0x0F, 0xC5, 0xF0, 0xC6, 0x55, 0xC7, 0x01,	// 208: V4-V7 = rand, masked
+		0x12, 0x00,										// 210: jump 200
+	};
+
+	// A typical device, as the Windows platform asks for.
+	static const UInt32 kBenchBeeperSampleRate = 48000;
+	static const UInt32 kBenchBeeperBufferSamples = 512;
+
+	struct BenchConfig
+	{
+		vector<UChar> mProgram;
+		UInt32 mThreads;
+		UInt32 mMachines;
+		UInt64 mInstructions;
+		UInt32 mBatch;
+		UInt32 mInstructionsPerFrame;
+		UInt32 mInstructionsPerTimerTick;
+		bool mJit;
+		const CompiledProgram* mCompiledProgram;
+	};
+
+	void printUsage()
+	{
+		cout << "usage: chip8bench [options] [game]" << endl;
+		cout << " --workload <name>           Built in workload when no game is given, compute, mixed or timers (default mixed)." << endl;
+		cout << " --instructions <n>          Instructions per machine (default 50000000)." << endl;
+		cout << " --machines <n>              Machines in total (default 1)." << endl;
+		cout << " --threads <n>               Threads to spread machines over (default 1)." << endl;
+		cout << " --batch <n>                 Instructions per run() call (default 1000)." << endl;
+		cout << " --jit                       Run translated native code rather than interpreting." << endl;
+		cout << " --aot                       Run ahead of time compiled code, the workload must be in CHIP8_AOT_ROMS." << endl;
+		cout << " --save-workload <file>      Write the workload out as a ROM, e.g. to compile it ahead of time." << endl;
+		cout << " --timer-tick <n>            Tick the timers every n instructions, checking run() against step() first (default 0, never)." << endl;
+		cout << " --expand <frames>           Compare the pixel expansion kernels against the byte at a time loop over this many frames." << endl;
+		cout << " --phosphor <frames>         Check the phosphor stage against a pixel at a time update, then time it over this many presents." << endl;
+		cout << " --pace <ms>                 Run the instruction clock at a range of rates for this long each and report how far it drifts." << endl;
+		cout << " --rand <draws>              Check CXNN repeats across machines, snapshots and threads, then time it against mt19937." << endl;
+		cout << " --beeper <buffers>          Check beeps start and stop on the samples their timestamps ask for, then time rendering this many buffers." << endl;
+#ifdef HEADLESS
+		cout << " --upscale <frames>          Time each upscaling filter over this many frames, on one thread and on --threads." << endl;
+		cout << " --scale <n>                 Scale for the nearest filter with --upscale (default 10)." << endl;
+#endif
+#ifdef HEADLESS
+		cout << " --loop                      Compare the host loop, one instruction per pass against whole frames." << endl;
+		cout << " --ipf <n>                   Instructions per frame for --loop (default " << kDefaultInstructionsPerFrame << ")." << endl;
+#endif
+	}
+
+	bool loadFile(const char* fileName, vector<UChar>& outProgram)
+	{
+		ifstream stream(fileName, ios::in | ios::binary);
+		if (!stream.is_open())
+		{
+			return false;
+		}
+		outProgram.assign(istreambuf_iterator<char>(stream), istreambuf_iterator<char>());
+		return true;
+	}
+
+	void runMachines(const BenchConfig& config, const UInt32 machineCount)
+	{
+		vector<Chip8Machine> machines(machineCount);
+		for (Chip8Machine& machine : machines)
+		{
+			machine.loadProgram(config.mProgram.data(), static_cast<UInt32>(config.mProgram.size()));
+			machine.setJitEnabled(config.mJit);
+			machine.setCompiledProgram(config.mCompiledProgram);
+			machine.setInstructionsPerTimerTick(config.mInstructionsPerTimerTick);
+		}
+
+		// Interleave machines batch by batch, the way a host running many of them would.
+		for (UInt64 executed = 0; executed < config.mInstructions; executed += config.mBatch)
+		{
+			for (Chip8Machine& machine : machines)
+			{
+				machine.run(config.mBatch);
+			}
+		}
+	}
+
+	// Timers that follow the instruction count have to read the same whichever way the instructions are run, batches included.
+	bool checkTimers(const BenchConfig& config)
+	{
+		Chip8Machine stepped;
+		Chip8Machine batched;
+		stepped.loadProgram(config.mProgram.data(), static_cast<UInt32>(config.mProgram.size()));
+		stepped.setInstructionsPerTimerTick(config.mInstructionsPerTimerTick);
+		batched.loadProgram(config.mProgram.data(), static_cast<UInt32>(config.mProgram.size()));
+		batched.setJitEnabled(config.mJit);
+		batched.setCompiledProgram(config.mCompiledProgram);
+		batched.setInstructionsPerTimerTick(config.mInstructionsPerTimerTick);
+
+		const UInt64 instructions = (config.mInstructions < 1000000) ? config.mInstructions : 1000000;
+		for (UInt64 executed = 0; executed < instructions; executed += config.mBatch)
+		{
+			batched.run(config.mBatch);
+			for (UInt32 i = 0; i < config.mBatch; ++i)
+			{
+				stepped.step();
+			}
+
+			const Chip8State& a = stepped.getState();
+			const Chip8State& b = batched.getState();
+			if ((memcmp(a.mV, b.mV, sizeof(a.mV)) != 0) || (a.mI != b.mI) || (a.mPC != b.mPC) || (a.mCycleCount != b.mCycleCount)
+				|| (stepped.getDelayTimer() != batched.getDelayTimer()) || (stepped.getSoundTimer() != batched.getSoundTimer()))
+			{
+				cerr << "Timers differ from stepping after " << (executed + config.mBatch) << " instructions" << endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void report(const char* label, const double instructions, const double seconds)
+	{
+		cout << label << ": " << instructions << " instructions in " << seconds << "s, "
+			<< (instructions / seconds) << " instructions/second" << endl;
+	}
+
+	// The byte at a time RGB24 loop platformDraw used before the expansion kernels.
+	void expandFrameReference(const UInt64* gfx, UChar* out)
+	{
+		static const Int32 kBytesPerPixel = 3;
+		for (Int32 i = 0; i < kGFXWidth * kGFXHeight; ++i)
+		{
+			const UChar currentByte = ((gfx[i / kGFXWidth] << (i % kGFXWidth)) >> 63) ? 0xFF : 0x00;
+			out[(i * kBytesPerPixel)] = currentByte;
+			out[((i * kBytesPerPixel) + 1)] = currentByte;
+			out[((i * kBytesPerPixel) + 2)] = currentByte;
+		}
+	}
+
+	void expandFrameRGB24(const UInt64* gfx, const PixelColours& colours, UChar* out)
+	{
+		for (Int32 y = 0; y < kGFXHeight; ++y)
+		{
+			expandRowRGB24(gfx[y], kGFXWidth, colours, out + (y * kGFXWidth * 3));
+		}
+	}
+
+	void expandFrameRGBA32(const UInt64* gfx, const PixelColours& colours, UInt32* out)
+	{
+		for (Int32 y = 0; y < kGFXHeight; ++y)
+		{
+			expandRowRGBA32(gfx[y], kGFXWidth, colours, out + (y * kGFXWidth));
+		}
+	}
+
+	// Times expanding frames whose rows change every pass, so nothing can be hoisted out of the loop.
+	template <typename Expand>
+	double timeExpand(const char* label, const UInt64 frames, UInt64* gfx, Expand expand)
+	{
+		const auto start = chrono::steady_clock::now();
+		for (UInt64 frame = 0; frame < frames; ++frame)
+		{
+			gfx[frame % kGFXHeight] += 0x9E3779B97F4A7C15ull;
+			expand(gfx);
+		}
+		const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+		const double pixels = static_cast<double>(frames) * kGFXWidth * kGFXHeight;
+		cout << label << ": " << frames << " frames in " << elapsed.count() << "s, " << (pixels / elapsed.count()) << " pixels/second" << endl;
+		return pixels / elapsed.count();
+	}
+
+	int runExpand(const UInt64 frames)
+	{
+		PixelColours colours;
+		setPixelColours(colours, kDefaultForegroundColour, kDefaultBackgroundColour);
+
+		UInt64 gfx[kGFXHeight];
+		mt19937_64 randGen(0);
+		for (UInt64& row : gfx)
+		{
+			row = randGen();
+		}
+
+		// The kernels have to match the loop they replace before their timings mean anything.
+		static UChar reference[kGFXWidth * kGFXHeight * 3];
+		static UChar rgb24[kGFXWidth * kGFXHeight * 3];
+		static UInt32 rgba32[kGFXWidth * kGFXHeight];
+		expandFrameReference(gfx, reference);
+		expandFrameRGB24(gfx, colours, rgb24);
+		expandFrameRGBA32(gfx, colours, rgba32);
+		for (Int32 i = 0; i < kGFXWidth * kGFXHeight; ++i)
+		{
+			const UInt32 expected = (reference[i * 3] != 0) ? kDefaultForegroundColour : kDefaultBackgroundColour;
+			if (memcmp(&reference[i * 3], &rgb24[i * 3], 3) != 0 || rgba32[i] != expected)
+			{
+				cerr << "Expansion kernel mismatch at pixel " << i << endl;
+				return 1;
+			}
+		}
+
+		cout << "kernel: " << getPixelExpandKernelName() << endl;
+		const double before = timeExpand("byte loop rgb24", frames, gfx, [](const UInt64* frame) { expandFrameReference(frame, reference); });
+		const double afterRGB24 = timeExpand("kernel rgb24", frames, gfx, [&colours](const UInt64* frame) { expandFrameRGB24(frame, colours, rgb24); });
+		const double afterRGBA32 = timeExpand("kernel rgba32", frames, gfx, [&colours](const UInt64* frame) { expandFrameRGBA32(frame, colours, rgba32); });
+		cout << "speedup rgb24: " << (afterRGB24 / before) << "x rgba32: " << (afterRGBA32 / before) << "x" << endl;
+		return 0;
+	}
+
+	// Times presents of the phosphor stage, every row of the frame changing on drawn presents and none on the rest.
+	double timePhosphor(const char* label, const UInt64 frames, const UInt64 drawEvery, UInt64* gfx)
+	{
+		Phosphor phosphor;
+		phosphor.configure(kDefaultPhosphorDecay);
+		static UInt32 out[kGFXWidth * kGFXHeight];
+
+		const auto start = chrono::steady_clock::now();
+		for (UInt64 frame = 0; frame < frames; ++frame)
+		{
+			UInt32 dirtyRows = 0;
+			if ((frame % drawEvery) == 0)
+			{
+				for (Int32 y = 0; y < kGFXHeight; ++y)
+				{
+					gfx[y] += 0x9E3779B97F4A7C15ull;
+				}
+				dirtyRows = kGFXAllRows;
+			}
+			const UInt32 changedRows = phosphor.update(gfx, kGFXWidth, kGFXHeight, dirtyRows);
+			if (changedRows != 0)
+			{
+				phosphor.writeRowsRGBA32(kGFXWidth, 0, kGFXHeight, 1, reinterpret_cast<UChar*>(out), kGFXWidth * sizeof(UInt32));
+			}
+		}
+		const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+		const double presents = static_cast<double>(frames);
+		cout << label << ": " << frames << " presents in " << elapsed.count() << "s, " << (elapsed.count() * 1e9 / presents) << "ns/present" << endl;
+		return presents / elapsed.count();
+	}
+
+	int runPhosphor(const UInt64 frames)
+	{
+		UInt64 gfx[kGFXHeight];
+		mt19937_64 randGen(0);
+		for (UInt64& row : gfx)
+		{
+			row = randGen();
+		}
+
+		// The stage has to match a pixel at a time update, fading pixels included, before its timings mean anything.
+		Phosphor phosphor;
+		phosphor.configure(kDefaultPhosphorDecay);
+		phosphor.setColours(0xFF, 0);
+		static UChar reference[kGFXHeight][kGFXWidth];
+		static UInt32 out[kGFXWidth * kGFXHeight];
+		memset(reference, 0, sizeof(reference));
+		for (UInt32 pass = 0; pass < 64; ++pass)
+		{
+			const Int32 changedRow = static_cast<Int32>(randGen() % kGFXHeight);
+			// The first present sees the whole frame, after that only the rows drawn to.
+			const UInt32 dirtyRows = (pass == 0) ? kGFXAllRows : (((pass & 3) == 0) ? (1u << changedRow) : 0);
+			if (dirtyRows != 0)
+			{
+				gfx[changedRow] = randGen();
+			}
+			phosphor.update(gfx, kGFXWidth, kGFXHeight, dirtyRows);
+			phosphor.writeRowsRGBA32(kGFXWidth, 0, kGFXHeight, 1, reinterpret_cast<UChar*>(out), kGFXWidth * sizeof(UInt32));
+
+			for (Int32 y = 0; y < kGFXHeight; ++y)
+			{
+				for (Int32 x = 0; x < kGFXWidth; ++x)
+				{
+					const bool lit = ((gfx[y] << x) >> 63) != 0;
+					reference[y][x] = static_cast<UChar>((lit) ? 0xFF : ((reference[y][x] * kDefaultPhosphorDecay) >> 8));
+					if (out[(y * kGFXWidth) + x] != reference[y][x])
+					{
+						cerr << "Phosphor mismatch at pass " << pass << " pixel " << x << ", " << y << endl;
+						return 1;
+					}
+				}
+			}
+		}
+
+		// Cost follows presents, not draws, a game drawing on every present is the worst case.
+		timePhosphor("drawn every present", frames, 1, gfx);
+		timePhosphor("drawn every 8th present", frames, 8, gfx);
+		return 0;
+	}
+
+	// Takes updates from a clock at perSecond for durationMS of wall time, then compares the count with what the rate asks for.
+	void measurePace(const UInt32 perSecond, const UInt64 durationMS)
+	{
+		UpdateClock clock;
+		startUpdateClock(clock, perSecond);
+
+		const auto start = chrono::steady_clock::now();
+		const auto toNS = [&start]() { return static_cast<UInt64>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count()) + 1; };
+		takeDueUpdates(clock, toNS(), 0);
+
+		const UInt64 durationNS = durationMS * kNSPerMS;
+		UInt64 updates = 0;
+		UInt64 now = toNS();
+		while (now < durationNS)
+		{
+			updates += takeDueUpdates(clock, now, 0xFFFFFFFF);
+			now = toNS();
+		}
+		updates += takeDueUpdates(clock, now, 0xFFFFFFFF);
+
+		const double expected = (static_cast<double>(now) * perSecond) / kNSPerSecond;
+		cout << perSecond << "/s: " << updates << " updates in " << (static_cast<double>(now) / kNSPerSecond) << "s, expected " << expected
+			<< ", drift " << ((static_cast<double>(updates) - expected) / perSecond * 1000.0) << "ms" << endl;
+	}
+
+	int runPace(const UInt64 durationMS)
+	{
+		static const UInt32 kRates[] = { 500, 600, 1001, 60000, 1000000, 25000000 };
+		for (const UInt32 perSecond : kRates)
+		{
+			measurePace(perSecond, durationMS);
+		}
+		return 0;
+	}
+
+	// Runs the CXNN workload from seed, in batches of batch instructions.
+	void runRandWorkload(Chip8Machine& machine, const UInt64 seed, const UInt64 draws, const UInt32 batch)
+	{
+		machine.setRandSeed(seed);
+		machine.loadProgram(kRandWorkload, sizeof(kRandWorkload));
+		for (UInt64 executed = 0; executed < draws; executed += batch)
+		{
+			machine.run(static_cast<UInt32>(((draws - executed) < batch) ? (draws - executed) : batch));
+		}
+	}
+
+	bool sameRand(const Chip8Machine& a, const Chip8Machine& b)
+	{
+		return (memcmp(a.getState().mV, b.getState().mV, sizeof(a.getState().mV)) == 0) && (a.getState().mRandState == b.getState().mRandState);
+	}
+
+	int runRand(const UInt64 draws)
+	{
+		static const UInt64 kSeed = 0x5EED;
+
+		// The same seed gives the same numbers whatever the batching or thread, and a restored snapshot carries on where it was taken.
+		Chip8Machine reference;
+		runRandWorkload(reference, kSeed, draws, 1000);
+
+		Chip8Machine batched;
+		runRandWorkload(batched, kSeed, draws / 2, 7);
+		const Chip8State snapshot = batched.getState();
+		batched.run(static_cast<UInt32>(draws - (draws / 2)));
+		Chip8Machine restored;
+		restored.setState(snapshot);
+		restored.run(static_cast<UInt32>(draws - (draws / 2)));
+
+		Chip8Machine threaded;
+		thread(runRandWorkload, ref(threaded), kSeed, draws, 1000).join();
+
+		Chip8Machine reseeded;
+		runRandWorkload(reseeded, kSeed + 1, draws, 1000);
+
+		if (!sameRand(reference, batched) || !sameRand(reference, restored) || !sameRand(reference, threaded) || sameRand(reference, reseeded))
+		{
+			cerr << "CXNN didn't repeat from its seed" << endl;
+			return 1;
+		}
+
+		// The old generator, one process wide mt19937 and a distribution built per call.
+		mt19937 randGen(static_cast<UInt32>(kSeed));
+		UInt32 sink = 0;
+		auto start = chrono::steady_clock::now();
+		for (UInt64 draw = 0; draw < draws; ++draw)
+		{
+			uniform_int_distribution<> dist(0, 0xFF);
+			sink += static_cast<UInt32>(dist(randGen));
+		}
+		const chrono::duration<double> before = chrono::steady_clock::now() - start;
+
+		Chip8Machine machine;
+		start = chrono::steady_clock::now();
+		runRandWorkload(machine, kSeed, draws, 1000);
+		const chrono::duration<double> after = chrono::steady_clock::now() - start;
+
+		cout << "mt19937: " << (before.count() * 1e9 / draws) << "ns/draw (" << (sink & 0xFF) << ")" << endl;
+		cout << "CXNN: " << (after.count() * 1e9 / draws) << "ns/instruction, dispatch included" << endl;
+		cout << "speedup: " << (before.count() / after.count()) << "x" << endl;
+		return 0;
+	}
+
+	// Renders a buffer as the audio callback would, the host clock having moved on a buffer since the last.
+	void renderBeeperBuffer(Beeper& beeper, Int16* out, UInt64& inOutBuffer, const UInt64 startNS)
+	{
+		beeper.render(out, kBenchBeeperBufferSamples, startNS + ((inOutBuffer * kBenchBeeperBufferSamples * kNSPerSecond) / kBenchBeeperSampleRate));
+		++inOutBuffer;
+	}
+
+	int runBeeper(const UInt64 buffers)
+	{
+		static Int16 out[kBenchBeeperBufferSamples];
+		const UInt64 startNS = kNSPerSecond;
+		// The stream's first sample is a latency, two buffers, behind the clock.
+		const UInt64 streamNS = startNS - ((2 * kBenchBeeperBufferSamples * kNSPerSecond) / kBenchBeeperSampleRate);
+		const UInt64 rampSamples = kBenchBeeperSampleRate / 2000;
+
+		Beeper beeper;
+		beeper.configure(kBenchBeeperSampleRate, kBenchBeeperBufferSamples);
+		UInt64 buffer = 0;
+		renderBeeperBuffer(beeper, out, buffer, startNS);
+
+		// Beeps at random offsets, some across buffer boundaries, each starting and stopping on the sample its timestamps ask for.
+		mt19937_64 randGen(0);
+		for (UInt32 beep = 0; beep < 64; ++beep)
+		{
+			const UInt64 firstSample = buffer * kBenchBeeperBufferSamples;
+			const UInt64 startSample = firstSample + (randGen() % kBenchBeeperBufferSamples);
+			const UInt64 stopSample = startSample + 64 + (randGen() % (2 * kBenchBeeperBufferSamples));
+			beeper.push(streamNS + (startSample * kNSPerSecond) / kBenchBeeperSampleRate, true);
+			beeper.push(streamNS + (stopSample * kNSPerSecond) / kBenchBeeperSampleRate, false);
+
+			UInt64 firstSound = 0;
+			UInt64 lastSound = 0;
+			bool sounded = false;
+			const UInt64 endSample = stopSample + (2 * rampSamples);
+			while (buffer * kBenchBeeperBufferSamples < endSample)
+			{
+				const UInt64 bufferSample = buffer * kBenchBeeperBufferSamples;
+				renderBeeperBuffer(beeper, out, buffer, startNS);
+				for (UInt32 i = 0; i < kBenchBeeperBufferSamples; ++i)
+				{
+					if (out[i] != 0)
+					{
+						firstSound = (sounded) ? firstSound : (bufferSample + i);
+						lastSound = bufferSample + i;
+						sounded = true;
+					}
+				}
+			}
+
+			// The band limited edge can put the first sample of a beep at zero, and a stop ramps out over half a millisecond.
+			// The ramp's last couple of samples can round to zero where they land on an edge of the wave.
+			const UInt64 expectedLastSound = stopSample + rampSamples - 1;
+			if (!sounded || firstSound > startSample + 1 || firstSound < startSample ||
+				lastSound + 2 < expectedLastSound || lastSound > expectedLastSound + 1)
+			{
+				cerr << "Beep " << beep << " expected samples " << startSample << " to " << expectedLastSound
+					<< ", sounded " << firstSound << " to " << lastSound << endl;
+				return 1;
+			}
+		}
+
+		// More events than the ring holds, the beeper settles on the newest once it has caught up.
+		for (UInt32 event = 0; event < 1001; ++event)
+		{
+			beeper.push(streamNS + ((buffer * kBenchBeeperBufferSamples * kNSPerSecond) / kBenchBeeperSampleRate), (event & 1) == 0);
+		}
+		for (UInt32 pass = 0; pass < 4; ++pass)
+		{
+			renderBeeperBuffer(beeper, out, buffer, startNS);
+		}
+		if (out[kBenchBeeperBufferSamples - 1] == 0 && out[kBenchBeeperBufferSamples - 2] == 0)
+		{
+			cerr << "Beeper didn't settle on the newest state after the ring overflowed" << endl;
+			return 1;
+		}
+
+		const auto start = chrono::steady_clock::now();
+		for (UInt64 pass = 0; pass < buffers; ++pass)
+		{
+			if ((pass & 7) == 0)
+			{
+				beeper.push(streamNS + ((buffer * kBenchBeeperBufferSamples * kNSPerSecond) / kBenchBeeperSampleRate), (pass & 8) == 0);
+			}
+			renderBeeperBuffer(beeper, out, buffer, startNS);
+		}
+		const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+		const double samples = static_cast<double>(buffers) * kBenchBeeperBufferSamples;
+		cout << "beeper: " << buffers << " buffers in " << elapsed.count() << "s, " << (elapsed.count() * 1e9 / samples) << "ns/sample, "
+			<< (samples / kBenchBeeperSampleRate / elapsed.count()) << "x real time" << endl;
+		return 0;
+	}
+
+#ifdef HEADLESS
+	void timeUpscale(const EUpscaleFilter::Type filter, const UInt32 nearestScale, const UInt32 threads, const UInt64 frames,
+		const PixelColours& colours, UInt64* gfx)
+	{
+		Upscaler upscaler;
+		upscaler.configure(filter, nearestScale, threads - 1);
+		const Int32 scale = static_cast<Int32>(upscaler.getScale());
+		const Int32 pitch = kGFXWidth * scale * static_cast<Int32>(sizeof(UInt32));
+		vector<UChar> out(static_cast<size_t>(pitch) * kGFXHeight * scale);
+
+		const auto start = chrono::steady_clock::now();
+		for (UInt64 frame = 0; frame < frames; ++frame)
+		{
+			gfx[frame % kGFXHeight] += 0x9E3779B97F4A7C15ull;
+			upscaler.upscale(gfx, kGFXWidth, kGFXHeight, 0, kGFXHeight, colours, out.data(), pitch);
+		}
+		const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+		const double pixels = static_cast<double>(frames) * out.size() / sizeof(UInt32);
+		cout << getUpscaleFilterName(filter) << " x" << scale << " threads " << threads << ": " << frames << " frames in " << elapsed.count() << "s, "
+			<< (pixels / elapsed.count()) << " output pixels/second" << endl;
+	}
+
+	int runUpscale(const UInt64 frames, const UInt32 nearestScale, const UInt32 threads)
+	{
+		PixelColours colours;
+		setPixelColours(colours, kDefaultForegroundColour, kDefaultBackgroundColour);
+
+		UInt64 gfx[kGFXHeight];
+		mt19937_64 randGen(0);
+		for (UInt64& row : gfx)
+		{
+			row = randGen();
+		}
+
+		cout << "kernel: " << getPixelExpandKernelName() << endl;
+		static const EUpscaleFilter::Type kFilters[] = { EUpscaleFilter::Nearest, EUpscaleFilter::Scale2x, EUpscaleFilter::Scale3x };
+		for (const EUpscaleFilter::Type filter : kFilters)
+		{
+			timeUpscale(filter, nearestScale, 1, frames, colours, gfx);
+			if (threads > 1)
+			{
+				timeUpscale(filter, nearestScale, threads, frames, colours, gfx);
+			}
+		}
+		return 0;
+	}
+
+	// Runs the program through the full host loop on the headless platform, polls are how it knows when to stop.
+	double runHostLoop(const BenchConfig& config, const UInt32 instructionsPerFrame)
+	{
+		Chip8Machine machine;
+		machine.loadProgram(config.mProgram.data(), static_cast<UInt32>(config.mProgram.size()));
+
+		EmuConfig emuConfig;
+		emuConfig.mInstructionsPerFrame = instructionsPerFrame;
+		emuConfig.mJit = config.mJit;
+		emuConfig.mCompiledProgram = config.mCompiledProgram;
+		const UInt64 polls = (instructionsPerFrame == 0) ? config.mInstructions : (config.mInstructions / instructionsPerFrame);
+		platformHeadlessSetMaxPolls(static_cast<UInt32>(polls));
+
+		EmuStats stats;
+		const auto start = chrono::steady_clock::now();
+		runLoop(machine, emuConfig, &stats);
+		const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+		report((instructionsPerFrame == 0) ? "per instruction" : "per frame", static_cast<double>(stats.mInstructions), elapsed.count());
+		return stats.mInstructions / elapsed.count();
+	}
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+	BenchConfig config;
+	config.mThreads = 1;
+	config.mMachines = 1;
+	config.mInstructions = 50000000;
+	config.mBatch = 1000;
+	config.mInstructionsPerFrame = kDefaultInstructionsPerFrame;
+	config.mInstructionsPerTimerTick = 0;
+	config.mJit = false;
+	config.mCompiledProgram = nullptr;
+	string workload = "mixed";
+	const char* gameName = nullptr;
+	bool hostLoop = false;
+	bool aot = false;
+	const char* saveName = nullptr;
+	UInt64 expandFrames = 0;
+	UInt64 phosphorFrames = 0;
+	UInt64 paceMS = 0;
+	UInt64 beeperBuffers = 0;
+	UInt64 randDraws = 0;
+	UInt64 upscaleFrames = 0;
+	UInt32 upscaleScale = 10;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const string arg(argv[i]);
+		const bool hasValue = (i + 1 < argc);
+		if (arg == "--workload" && hasValue)
+		{
+			workload = argv[++i];
+		}
+		else if (arg == "--instructions" && hasValue)
+		{
+			config.mInstructions = strtoull(argv[++i], nullptr, 0);
+		}
+		else if (arg == "--machines" && hasValue)
+		{
+			config.mMachines = static_cast<UInt32>(strtoul(argv[++i], nullptr, 0));
+		}
+		else if (arg == "--threads" && hasValue)
+		{
+			config.mThreads = static_cast<UInt32>(strtoul(argv[++i], nullptr, 0));
+		}
+		else if (arg == "--batch" && hasValue)
+		{
+			config.mBatch = static_cast<UInt32>(strtoul(argv[++i], nullptr, 0));
+		}
+		else if (arg == "--jit")
+		{
+			config.mJit = true;
+		}
+		else if (arg == "--aot")
+		{
+			aot = true;
+		}
+		else if (arg == "--save-workload" && hasValue)
+		{
+			saveName = argv[++i];
+		}
+		else if (arg == "--timer-tick" && hasValue)
+		{
+			config.mInstructionsPerTimerTick = static_cast<UInt32>(strtoul(argv[++i], nullptr, 0));
+		}
+		else if (arg == "--expand" && hasValue)
+		{
+			expandFrames = strtoull(argv[++i], nullptr, 0);
+		}
+		else if (arg == "--phosphor" && hasValue)
+		{
+			phosphorFrames = strtoull(argv[++i], nullptr, 0);
+		}
+		else if (arg == "--pace" && hasValue)
+		{
+			paceMS = strtoull(argv[++i], nullptr, 0);
+		}
+		else if (arg == "--rand" && hasValue)
+		{
+			randDraws = strtoull(argv[++i], nullptr, 0);
+		}
+		else if (arg == "--beeper" && hasValue)
+		{
+			beeperBuffers = strtoull(argv[++i], nullptr, 0);
+		}
+#ifdef HEADLESS
+		else if (arg == "--loop")
+		{
+			hostLoop = true;
+		}
+		else if (arg == "--ipf" && hasValue)
+		{
+			config.mInstructionsPerFrame = static_cast<UInt32>(strtoul(argv[++i], nullptr, 0));
+		}
+		else if (arg == "--upscale" && hasValue)
+		{
+			upscaleFrames = strtoull(argv[++i], nullptr, 0);
+		}
+		else if (arg == "--scale" && hasValue)
+		{
+			upscaleScale = static_cast<UInt32>(strtoul(argv[++i], nullptr, 0));
+		}
+#endif
+		else if (arg[0] != '-' && !gameName)
+		{
+			gameName = argv[i];
+		}
+		else
+		{
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (expandFrames != 0)
+	{
+		return runExpand(expandFrames);
+	}
+
+	if (phosphorFrames != 0)
+	{
+		return runPhosphor(phosphorFrames);
+	}
+
+	if (paceMS != 0)
+	{
+		return runPace(paceMS);
+	}
+
+	if (beeperBuffers != 0)
+	{
+		return runBeeper(beeperBuffers);
+	}
+
+	if (randDraws != 0)
+	{
+		return runRand(randDraws);
+	}
+
+#ifdef HEADLESS
+	if (upscaleFrames != 0)
+	{
+		return runUpscale(upscaleFrames, upscaleScale, (config.mThreads == 0) ? 1 : config.mThreads);
+	}
+#endif
+
+	if (config.mThreads == 0 || config.mMachines < config.mThreads || config.mBatch == 0)
+	{
+		cerr << "Need at least one thread, one machine per thread and a non zero batch." << endl;
+		return 1;
+	}
+
+	if (gameName)
+	{
+		if (!loadFile(gameName, config.mProgram))
+		{
+			cerr << "Could not load game: " << gameName << endl;
+			return 1;
+		}
+		workload = gameName;
+	}
+	else if (workload == "compute")
+	{
+		config.mProgram.assign(kComputeWorkload, kComputeWorkload + sizeof(kComputeWorkload));
+	}
+	else if (workload == "mixed")
+	{
+		config.mProgram.assign(kMixedWorkload, kMixedWorkload + sizeof(kMixedWorkload));
+	}
+	else if (workload == "timers")
+	{
+		config.mProgram.assign(kTimersWorkload, kTimersWorkload + sizeof(kTimersWorkload));
+	}
+	else
+	{
+		printUsage();
+		return 1;
+	}
+
+	if (saveName)
+	{
+		ofstream stream(saveName, ios::out | ios::binary);
+		stream.write(reinterpret_cast<const char*>(config.mProgram.data()), config.mProgram.size());
+		if (!stream.good())
+		{
+			cerr << "Could not write: " << saveName << endl;
+			return 1;
+		}
+		return 0;
+	}
+
+	if (aot)
+	{
+		config.mCompiledProgram = findCompiledProgram(config.mProgram.data(), static_cast<UInt32>(config.mProgram.size()));
+		if (!config.mCompiledProgram)
+		{
+			cerr << "No compiled code for workload: " << workload << endl;
+			return 1;
+		}
+	}
+
+#ifdef HEADLESS
+	if (hostLoop)
+	{
+		if (config.mInstructionsPerFrame == 0)
+		{
+			cerr << "--loop needs a non zero --ipf to compare against." << endl;
+			return 1;
+		}
+
+		cout << "workload: " << workload << endl;
+		const double before = runHostLoop(config, 0);
+		const double after = runHostLoop(config, config.mInstructionsPerFrame);
+		cout << "speedup: " << (after / before) << "x" << endl;
+		return 0;
+	}
+#endif
+
+	if (config.mJit && !Chip8Machine().setJitEnabled(true))
+	{
+		cerr << "The JIT isn't available on this host." << endl;
+		return 1;
+	}
+
+	// Round the instruction count to whole batches so the total is exact.
+	config.mInstructions = ((config.mInstructions + config.mBatch - 1) / config.mBatch) * config.mBatch;
+
+	if (config.mInstructionsPerTimerTick != 0 && !checkTimers(config))
+	{
+		return 1;
+	}
+
+	const auto start = chrono::steady_clock::now();
+	vector<thread> threads;
+	for (UInt32 t = 0; t < config.mThreads; ++t)
+	{
+		const UInt32 machineCount = (config.mMachines / config.mThreads) + ((t < config.mMachines % config.mThreads) ? 1 : 0);
+		threads.emplace_back(runMachines, cref(config), machineCount);
+	}
+	for (thread& t : threads)
+	{
+		t.join();
+	}
+	const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+	cout << "workload: " << workload << endl;
+	cout << "machines: " << config.mMachines << " threads: " << config.mThreads << endl;
+	report("run", static_cast<double>(config.mInstructions) * config.mMachines, elapsed.count());
+	return 0;
+}
\ No newline at end of file
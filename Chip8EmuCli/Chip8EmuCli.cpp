@@ -0,0 +1,187 @@
+// Chip8EmuCli.cpp : Headless command line runner.
+//
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "Chip8Emu/Aot.h"
+#include "Chip8Emu/Emu.h"
+#include "Chip8Emu/Machine.h"
+#include "Chip8Emu/PlatformHeadless.h"
+
+using namespace std;
+using namespace SynchingFeeling;
+
+namespace
+{
+	void printUsage()
+	{
+		cout << "Chip8Emu (Headless)" << endl;
+		cout << "usage: chip8cli <game> [options]" << endl;
+		cout << " --script <file>      Input script / movie to replay." << endl;
+		cout << " --max-polls <n>      Quit after n input polls (default 100000 if there is no script)." << endl;
+		cout << " --seed <n>           Random seed for CXNN, 64 bit." << endl;
+		cout << " --ipf <n>            Instructions per 60Hz frame, 0 for the one instruction per pass loop (default " << kDefaultInstructionsPerFrame << ")." << endl;
+		cout << " --jit                Run translated native code where supported." << endl;
+		cout << " --aot                Run the game's ahead of time compiled code, it must be in CHIP8_AOT_ROMS." << endl;
+		cout << " --wrap-sprites       Wrap sprites drawn across the edge of the screen rather than clipping them." << endl;
+		cout << " --speed <mode>       realtime, <N>x or uncapped, timers tick with emulated frames when uncapped (default realtime)." << endl;
+		cout << " --no-draw            Uncapped only, skip drawing and deliver just the last frame." << endl;
+		cout << " --emulated-timers    Tick the timers off the instruction count rather than wall time, always on when uncapped." << endl;
+		cout << " --dump-frame <file>  Write the last frame as a PBM image on exit." << endl;
+	}
+
+	bool findCompiled(const char* gameName, EmuConfig& config)
+	{
+		ifstream stream(gameName, ios::in | ios::binary);
+		if (!stream.is_open())
+		{
+			return false;
+		}
+		const string rom((istreambuf_iterator<char>(stream)), istreambuf_iterator<char>());
+		config.mCompiledProgram = findCompiledProgram(reinterpret_cast<const UChar*>(rom.data()), static_cast<UInt32>(rom.size()));
+		return config.mCompiledProgram != nullptr;
+	}
+
+	bool dumpFrame(const char* fileName, const UChar* frame)
+	{
+		ofstream stream(fileName, ios::out | ios::binary);
+		if (!stream.is_open())
+		{
+			return false;
+		}
+
+		stream << "P1\n" << kGFXWidth << " " << kGFXHeight << "\n";
+		for (Int32 y = 0; y < kGFXHeight; ++y)
+		{
+			for (Int32 x = 0; x < kGFXWidth; ++x)
+			{
+				stream << ((frame[x + (y * kGFXWidth)] != 0) ? '1' : '0');
+			}
+			stream << "\n";
+		}
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		printUsage();
+		return 1;
+	}
+
+	const char* gameName = argv[1];
+	const char* scriptName = nullptr;
+	const char* dumpFrameName = nullptr;
+	UInt32 maxPolls = 0;
+	bool maxPollsSet = false;
+	bool aot = false;
+	EmuConfig config;
+
+	for (int i = 2; i < argc; ++i)
+	{
+		const string arg(argv[i]);
+		const bool hasValue = (i + 1 < argc);
+		if (arg == "--script" && hasValue)
+		{
+			scriptName = argv[++i];
+		}
+		else if (arg == "--max-polls" && hasValue)
+		{
+			maxPolls = static_cast<UInt32>(strtoul(argv[++i], nullptr, 0));
+			maxPollsSet = true;
+		}
+		else if (arg == "--seed" && hasValue)
+		{
+			platformHeadlessSetRandSeed(static_cast<UInt64>(strtoull(argv[++i], nullptr, 0)));
+		}
+		else if (arg == "--ipf" && hasValue)
+		{
+			config.mInstructionsPerFrame = static_cast<UInt32>(strtoul(argv[++i], nullptr, 0));
+		}
+		else if (arg == "--jit")
+		{
+			config.mJit = true;
+		}
+		else if (arg == "--aot")
+		{
+			aot = true;
+		}
+		else if (arg == "--speed" && hasValue)
+		{
+			if (!findSpeedMode(argv[++i], config.mSpeedMode, config.mSpeedMultiplier))
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (arg == "--no-draw")
+		{
+			config.mDrawWhenUncapped = false;
+		}
+		else if (arg == "--emulated-timers")
+		{
+			config.mTimersFollowInstructions = true;
+		}
+		else if (arg == "--wrap-sprites")
+		{
+			config.mWrapSprites = true;
+		}
+		else if (arg == "--dump-frame" && hasValue)
+		{
+			dumpFrameName = argv[++i];
+		}
+		else
+		{
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (aot && !findCompiled(gameName, config))
+	{
+		cerr << "No compiled code for: " << gameName << endl;
+		return 1;
+	}
+
+	if (scriptName && !platformHeadlessLoadInputScript(scriptName))
+	{
+		cerr << "Could not load input script: " << scriptName << endl;
+		return 1;
+	}
+
+	// Without a script nothing would ever ask us to quit.
+	if (!scriptName && !maxPollsSet)
+	{
+		maxPolls = 100000;
+	}
+	platformHeadlessSetMaxPolls(maxPolls);
+
+	static UChar frame[kGFXWidth * kGFXHeight];
+	platformHeadlessSetFrameBuffer(frame, sizeof(frame));
+
+	const auto start = chrono::steady_clock::now();
+	EmuStats stats;
+	mainLoop(gameName, config, &stats);
+	const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+	cout << "polls: " << platformHeadlessGetPollCount() << endl;
+	cout << "frames: " << stats.mFrames << endl;
+	cout << "draws: " << stats.mDraws << endl;
+	cout << "dropped frames: " << stats.mDroppedFrames << endl;
+	cout << "present latency ms (mean/max): " << ((stats.mDraws != 0) ? (static_cast<double>(stats.mPresentLatencyTotalMS) / stats.mDraws) : 0.0) << "/" << stats.mPresentLatencyMaxMS << endl;
+	cout << "instructions: " << stats.mInstructions << endl;
+	cout << "seconds: " << elapsed.count() << endl;
+	cout << "instructions/second: " << (stats.mInstructions / elapsed.count()) << endl;
+
+	if (dumpFrameName && !dumpFrame(dumpFrameName, frame))
+	{
+		cerr << "Could not write frame: " << dumpFrameName << endl;
+		return 1;
+	}
+	return 0;
+}
\ No newline at end of file